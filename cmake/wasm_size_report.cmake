@@ -0,0 +1,260 @@
+# Reports the size of a contract wasm per section and its largest functions, run after every contract build so code size
+# changes show up next to the change that caused them.
+#
+#   cmake -DWASM=<contract.wasm> [-DREPORT=<file>] [-DTOP=<functions>] -P wasm_size_report.cmake
+#
+# Function names come from the "name" section when the contract is linked with one (they are the mangled symbol names),
+# otherwise exported functions show their export name and the rest their function index.
+
+cmake_minimum_required(VERSION 3.25)
+
+if(NOT WASM)
+   message(FATAL_ERROR "WASM is not set")
+endif()
+if(NOT TOP)
+   set(TOP 20)
+endif()
+
+file(SIZE "${WASM}" wasm_size)
+
+# the module is read a few bytes at a time, expanding the whole file into a variable makes every lookup copy it
+function(read_hex offset count out)
+   file(READ "${WASM}" hex OFFSET ${offset} LIMIT ${count} HEX)
+   set(${out} "${hex}" PARENT_SCOPE)
+endfunction()
+
+function(read_byte offset out)
+   read_hex(${offset} 1 hex)
+   if(hex STREQUAL "")
+      message(FATAL_ERROR "${WASM} is truncated at offset ${offset}")
+   endif()
+   math(EXPR value "0x${hex}")
+   set(${out} ${value} PARENT_SCOPE)
+endfunction()
+
+# decodes the u32 LEB128 at `offset` into `out`, and sets `next` to the offset after it
+function(read_leb offset out next)
+   read_hex(${offset} 5 hex)
+   string(LENGTH "${hex}" length)
+   set(value 0)
+   set(shift 0)
+   set(pos 0)
+   while(pos LESS length)
+      string(SUBSTRING "${hex}" ${pos} 2 b)
+      math(EXPR byte "0x${b}")
+      math(EXPR value "${value} + ((${byte} & 0x7f) << ${shift})")
+      math(EXPR pos "${pos} + 2")
+      if(byte LESS 128)
+         math(EXPR end "${offset} + ${pos} / 2")
+         set(${out} ${value} PARENT_SCOPE)
+         set(${next} ${end} PARENT_SCOPE)
+         return()
+      endif()
+      math(EXPR shift "${shift} + 7")
+   endwhile()
+   message(FATAL_ERROR "${WASM} has a malformed LEB128 at offset ${offset}")
+endfunction()
+
+function(read_string offset length out)
+   read_hex(${offset} ${length} hex)
+   string(LENGTH "${hex}" hex_length)
+   set(text "")
+   set(pos 0)
+   while(pos LESS hex_length)
+      string(SUBSTRING "${hex}" ${pos} 2 b)
+      math(EXPR c "0x${b}")
+      string(ASCII ${c} ch)
+      string(APPEND text "${ch}")
+      math(EXPR pos "${pos} + 2")
+   endwhile()
+   set(${out} "${text}" PARENT_SCOPE)
+endfunction()
+
+function(pad_left value width out)
+   string(LENGTH "${value}" length)
+   set(padded "${value}")
+   if(length LESS width)
+      math(EXPR missing "${width} - ${length}")
+      string(REPEAT " " ${missing} spaces)
+      set(padded "${spaces}${value}")
+   endif()
+   set(${out} "${padded}" PARENT_SCOPE)
+endfunction()
+
+function(pad_right value width out)
+   string(LENGTH "${value}" length)
+   set(padded "${value}")
+   if(length LESS width)
+      math(EXPR missing "${width} - ${length}")
+      string(REPEAT " " ${missing} spaces)
+      set(padded "${value}${spaces}")
+   endif()
+   set(${out} "${padded}" PARENT_SCOPE)
+endfunction()
+
+# skips the limits of an imported table or memory
+macro(skip_limits)
+   read_byte(${pos} flags)
+   math(EXPR pos "${pos} + 1")
+   read_leb(${pos} limit pos)
+   math(EXPR has_max "${flags} & 1")
+   if(has_max)
+      read_leb(${pos} limit pos)
+   endif()
+endmacro()
+
+read_hex(0 8 magic)
+if(NOT magic STREQUAL "0061736d01000000")
+   message(FATAL_ERROR "${WASM} is not a wasm module")
+endif()
+
+set(section_names type import function table memory global export start element code data datacount)
+set(sections "")
+set(functions "")
+set(imported_functions 0)
+set(code_size 0)
+
+set(offset 8)
+while(offset LESS wasm_size)
+   read_byte(${offset} id)
+   math(EXPR header_end "${offset} + 1")
+   read_leb(${header_end} size payload)
+   math(EXPR section_end "${payload} + ${size}")
+   math(EXPR section_size "${section_end} - ${offset}")
+
+   if(id EQUAL 0)
+      read_leb(${payload} length name_offset)
+      read_string(${name_offset} ${length} custom_name)
+      set(label "custom:${custom_name}")
+
+      # function names, subsection 1 of the name section
+      if(custom_name STREQUAL "name")
+         math(EXPR pos "${name_offset} + ${length}")
+         while(pos LESS section_end)
+            read_byte(${pos} subsection)
+            math(EXPR pos "${pos} + 1")
+            read_leb(${pos} subsection_size pos)
+            math(EXPR subsection_end "${pos} + ${subsection_size}")
+            if(subsection EQUAL 1)
+               read_leb(${pos} count pos)
+               set(i 0)
+               while(i LESS count)
+                  read_leb(${pos} index pos)
+                  read_leb(${pos} length pos)
+                  set(name_offset_${index} ${pos})
+                  set(name_length_${index} ${length})
+                  math(EXPR pos "${pos} + ${length}")
+                  math(EXPR i "${i} + 1")
+               endwhile()
+            endif()
+            set(pos ${subsection_end})
+         endwhile()
+      endif()
+   elseif(id LESS_EQUAL 12)
+      math(EXPR i "${id} - 1")
+      list(GET section_names ${i} label)
+   else()
+      set(label "unknown:${id}")
+   endif()
+
+   # imported functions come first in the function index space
+   if(id EQUAL 2)
+      read_leb(${payload} count pos)
+      set(i 0)
+      while(i LESS count)
+         read_leb(${pos} length pos)
+         math(EXPR pos "${pos} + ${length}")
+         read_leb(${pos} length pos)
+         math(EXPR pos "${pos} + ${length}")
+         read_byte(${pos} kind)
+         math(EXPR pos "${pos} + 1")
+         if(kind EQUAL 0)
+            read_leb(${pos} type pos)
+            math(EXPR imported_functions "${imported_functions} + 1")
+         elseif(kind EQUAL 1)
+            math(EXPR pos "${pos} + 1")
+            skip_limits()
+         elseif(kind EQUAL 2)
+            skip_limits()
+         else()
+            math(EXPR pos "${pos} + 2")
+         endif()
+         math(EXPR i "${i} + 1")
+      endwhile()
+   endif()
+
+   if(id EQUAL 7)
+      read_leb(${payload} count pos)
+      set(i 0)
+      while(i LESS count)
+         read_leb(${pos} length pos)
+         set(export_offset ${pos})
+         set(export_length ${length})
+         math(EXPR pos "${pos} + ${length}")
+         read_byte(${pos} kind)
+         math(EXPR pos "${pos} + 1")
+         read_leb(${pos} index pos)
+         if(kind EQUAL 0)
+            set(export_offset_${index} ${export_offset})
+            set(export_length_${index} ${export_length})
+         endif()
+         math(EXPR i "${i} + 1")
+      endwhile()
+   endif()
+
+   # function bodies, keyed by their zero padded size so a string sort orders them by size
+   if(id EQUAL 10)
+      read_leb(${payload} count pos)
+      set(i 0)
+      while(i LESS count)
+         read_leb(${pos} body_size body)
+         math(EXPR index "${imported_functions} + ${i}")
+         string(LENGTH "${body_size}" digits)
+         math(EXPR missing "10 - ${digits}")
+         string(REPEAT "0" ${missing} zeros)
+         list(APPEND functions "${zeros}${body_size}:${index}")
+         math(EXPR code_size "${code_size} + ${body_size}")
+         math(EXPR pos "${body} + ${body_size}")
+         math(EXPR i "${i} + 1")
+      endwhile()
+   endif()
+
+   list(APPEND sections "${label}=${section_size}")
+   set(offset ${section_end})
+endwhile()
+
+get_filename_component(wasm_name "${WASM}" NAME)
+set(report "${wasm_name}: ${wasm_size} bytes\n\nsections\n")
+foreach(section IN LISTS sections)
+   string(REGEX REPLACE "^(.*)=([0-9]+)$" "\\1" label "${section}")
+   string(REGEX REPLACE "^(.*)=([0-9]+)$" "\\2" size "${section}")
+   pad_right("${label}" 24 label)
+   pad_left("${size}" 10 size)
+   string(APPEND report "   ${label}${size}\n")
+endforeach()
+
+list(LENGTH functions function_count)
+string(APPEND report "\n${function_count} functions, ${code_size} bytes of function bodies, largest first\n")
+
+list(SORT functions ORDER DESCENDING)
+if(function_count GREATER TOP)
+   list(SUBLIST functions 0 ${TOP} functions)
+endif()
+foreach(function IN LISTS functions)
+   string(REGEX REPLACE "^0*([0-9]+):([0-9]+)$" "\\1" size "${function}")
+   string(REGEX REPLACE "^0*([0-9]+):([0-9]+)$" "\\2" index "${function}")
+   if(DEFINED name_offset_${index})
+      read_string(${name_offset_${index}} ${name_length_${index}} label)
+   elseif(DEFINED export_offset_${index})
+      read_string(${export_offset_${index}} ${export_length_${index}} label)
+   else()
+      set(label "function ${index}")
+   endif()
+   pad_left("${size}" 10 size)
+   string(APPEND report "${size}   ${label}\n")
+endforeach()
+
+if(REPORT)
+   file(WRITE "${REPORT}" "${report}")
+endif()
+message(STATUS "wasm size report\n${report}")
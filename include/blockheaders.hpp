@@ -0,0 +1,61 @@
+#pragma once
+
+#include <eosio/eosio.hpp>
+#include <eosio/crypto.hpp>
+
+#include <optional>
+#include <vector>
+
+#include <bridge.hpp>
+
+namespace blockheaders {
+
+   using eosio::checksum256;
+
+   // block header whose serialized form, digest and id are computed on first use and reused afterwards. It refers to the
+   // header, which must outlive it.
+   class memo {
+      public:
+         explicit memo(const bridge::blockheader& header) : _header(header) {}
+
+         // a header whose id is already known, e.g. from expanding the compact proof it came in
+         memo(const bridge::blockheader& header, const std::optional<checksum256>& id) : _header(header), _id(id) {}
+
+         const bridge::blockheader& header() const { return _header; }
+
+         const std::vector<char>& packed() const {
+            if (_packed.empty()) _packed = eosio::pack(_header);
+            return _packed;
+         }
+
+         const checksum256& digest() const {
+            if (!_digest) _digest = eosio::sha256(packed().data(), packed().size());
+            return *_digest;
+         }
+
+         uint32_t block_num() const { return bridge::get_block_num_from_id(_header.previous) + 1; }
+
+         const checksum256& id() const {
+            if (!_id) _id = bridge::compute_block_id(digest(), block_num());
+            return *_id;
+         }
+
+         bool has_id() const { return _id.has_value(); }
+
+      private:
+         const bridge::blockheader&             _header;
+         mutable std::vector<char>              _packed;
+         mutable std::optional<checksum256>     _digest;
+         mutable std::optional<checksum256>     _id;
+   };
+
+   // memos of the proven header and the bftproof headers of a heavy proof, in proof order
+   static std::vector<memo> memos(const bridge::heavyproof& proof) {
+      std::vector<memo> result;
+      result.reserve(proof.bftproof.size() + 1);
+      result.emplace_back(proof.blocktoprove.block.header);
+      for (const bridge::sblockheader& sh : proof.bftproof) result.emplace_back(sh.header);
+      return result;
+   }
+
+}
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <eosio/eosio.hpp>
 #include <eosio/system.hpp>
 #include <eosio/crypto.hpp>
@@ -40,31 +42,21 @@ CONTRACT bridge : public contract {
 		}
 
 
-		static checksum256 compute_block_id(checksum256 hash, uint32_t block_num) { 
-
-		  uint8_t fullraw[32] = {0};
-
-		  uint32_t r_block_num = reverse_bytes(block_num);
+		// the block number replaces the top 32 bits of the digest, which are its first four bytes in big endian order
+		static checksum256 compute_block_id(const checksum256& hash, uint32_t block_num) { 
 
-		  std::array<uint8_t, 32> ab =  hash.extract_as_byte_array();
+		  auto words = hash.get_array();
 
-		  memcpy(&fullraw[0], (uint8_t *)&r_block_num, 4);
+		  using word = checksum256::word_t;
+		  words[0] = (words[0] & ~(word(0xffffffff) << 96)) | (word(block_num) << 96);
 
-		  for (int i = 4; i <32; i++){
-		    memcpy(&fullraw[i], (uint8_t *)&ab[i], 1);
-		  }
-
-		  return checksum256(fullraw);
+		  return checksum256(words);
 
 		}
 
-		static uint32_t get_block_num_from_id(checksum256 id) {
-		  
-		  std::array<uint8_t, 32> ab =  id.extract_as_byte_array();
-
-		  uint32_t block_num = ab[3] | (ab[2] << 8) | (ab[1] << 16) | (ab[0] << 24);
+		static uint32_t get_block_num_from_id(const checksum256& id) {
 
-		  return block_num;
+		  return uint32_t(id.get_array()[0] >> 96);
 
 		}
 
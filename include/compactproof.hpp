@@ -0,0 +1,135 @@
+#pragma once
+
+#include <eosio/eosio.hpp>
+#include <eosio/crypto.hpp>
+#include <eosio/varint.hpp>
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include <blockheaders.hpp>
+#include <bridge.hpp>
+#include <merkle.hpp>
+
+// compact wire encoding of a heavy proof, expanded by the contract before it is handed to the bridge
+namespace compactproof {
+
+   using eosio::checksum256;
+   using eosio::name;
+   using eosio::unsigned_int;
+
+   // signed block header, encoded relative to the header before it in the proof
+   struct compactheader {
+      unsigned_int                                             slot_delta;          // timestamp slot minus the prior header's
+      unsigned_int                                             producer;            // index into the proof's producers
+      unsigned_int                                             confirmed;
+      std::optional<checksum256>                               previous;            // absent when the prior header is the previous block
+      checksum256                                              transaction_mroot;
+      checksum256                                              action_mroot;
+      unsigned_int                                             schedule_delta;      // schedule version minus the prior header's
+      std::optional<eosio::producer_schedule>                  new_producers;
+      std::vector<std::pair<uint16_t, std::vector<char>>>      header_extensions;
+      std::vector<eosio::signature>                            producer_signatures;
+      unsigned_int                                             previous_bmroot;     // hash reference
+      std::vector<unsigned_int>                                bmproofpath;         // hash references
+
+      EOSLIB_SERIALIZE( compactheader, (slot_delta)(producer)(confirmed)(previous)(transaction_mroot)(action_mroot)(schedule_delta)
+                                       (new_producers)(header_extensions)(producer_signatures)(previous_bmroot)(bmproofpath) )
+   };
+
+   // heavy proof with deduplicated hashes and producer names. A hash reference is twice the index of a hash in `hashes`, plus
+   // its top bit, which carries the canonical left/right flag of merkle path nodes and is cleared in `hashes` so that a node used
+   // on both sides is stored once.
+   struct compactheavyproof {
+      checksum256                      chain_id;
+      std::vector<checksum256>         hashes;
+      std::vector<name>                producers;
+      compactheader                    blocktoprove;
+      std::vector<unsigned_int>        active_nodes;        // hash references
+      uint64_t                         node_count;
+      std::vector<compactheader>       bftproof;            // each relative to the header before it, the first to blocktoprove
+
+      EOSLIB_SERIALIZE( compactheavyproof, (chain_id)(hashes)(producers)(blocktoprove)(active_nodes)(node_count)(bftproof) )
+   };
+
+   // rebuilds the heavy proof the compact proof was made from, up to the order of its hashes. The id of every header is derived at
+   // most once, and the id of the proven header is stored in `proven_id` when deriving the next header needed it.
+   static bridge::heavyproof expand(const compactheavyproof& proof, std::optional<checksum256>* proven_id = nullptr) {
+      bridge::heavyproof hp;
+      hp.chain_id = proof.chain_id;
+
+      auto hash_of = [&](const unsigned_int& ref) {
+         eosio::check(ref.value / 2 < proof.hashes.size(), "invalid hash reference");
+         const checksum256& hash = proof.hashes[ref.value / 2];
+         return (ref.value & 1) ? merkle::make_canonical_right(hash) : merkle::make_canonical_left(hash);
+      };
+
+      std::map<uint32_t, uint16_t> positions;
+      auto index_of = [&](const unsigned_int& ref) {
+         auto [itr, inserted] = positions.try_emplace(ref.value, uint16_t(hp.hashes.size()));
+         if (inserted) {
+            eosio::check(hp.hashes.size() < 0x10000, "too many hashes in proof");
+            hp.hashes.push_back(hash_of(ref));
+         }
+         return itr->second;
+      };
+
+      auto expand_header = [&](const compactheader& c, const blockheaders::memo* prior) {
+         bridge::sblockheader sh;
+         bridge::blockheader& h = sh.header;
+
+         const uint64_t slot = uint64_t(prior ? prior->header().timestamp.slot : 0) + c.slot_delta.value;
+         eosio::check(slot <= UINT32_MAX, "invalid header timestamp");
+         h.timestamp = eosio::block_timestamp(uint32_t(slot));
+
+         eosio::check(c.producer.value < proof.producers.size(), "invalid producer reference");
+         h.producer = proof.producers[c.producer.value];
+
+         eosio::check(c.confirmed.value <= UINT16_MAX, "invalid header confirmation count");
+         h.confirmed = uint16_t(c.confirmed.value);
+
+         if (c.previous) h.previous = *c.previous;
+         else {
+            eosio::check(prior != nullptr, "proven block header must carry its previous block id");
+            h.previous = prior->id();
+         }
+
+         h.transaction_mroot = c.transaction_mroot;
+         h.action_mroot = c.action_mroot;
+
+         const uint64_t schedule_version = uint64_t(prior ? prior->header().schedule_version : 0) + c.schedule_delta.value;
+         eosio::check(schedule_version <= UINT32_MAX, "invalid header schedule version");
+         h.schedule_version = uint32_t(schedule_version);
+
+         h.new_producers = c.new_producers;
+         h.header_extensions = c.header_extensions;
+
+         sh.producer_signatures = c.producer_signatures;
+         sh.previous_bmroot = hash_of(c.previous_bmroot);
+         for (const unsigned_int& ref : c.bmproofpath) sh.bmproofpath.push_back(index_of(ref));
+
+         return sh;
+      };
+
+      hp.blocktoprove.block = expand_header(proof.blocktoprove, nullptr);
+      for (const unsigned_int& ref : proof.active_nodes) hp.blocktoprove.active_nodes.push_back(index_of(ref));
+      hp.blocktoprove.node_count = proof.node_count;
+
+      // the reserved vectors keep the headers and memos in place while they are appended to
+      const blockheaders::memo proven(hp.blocktoprove.block.header);
+      std::vector<blockheaders::memo> memos;
+      memos.reserve(proof.bftproof.size());
+      hp.bftproof.reserve(proof.bftproof.size());
+      for (const compactheader& c : proof.bftproof) {
+         hp.bftproof.push_back(expand_header(c, memos.empty() ? &proven : &memos.back()));
+         memos.emplace_back(hp.bftproof.back().header);
+      }
+
+      if (proven_id && proven.has_id()) *proven_id = proven.id();
+
+      return hp;
+   }
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <eosio/eosio.hpp>
+#include <eosio/crypto.hpp>
+
+#include <array>
+#include <tuple>
+#include <vector>
+
+#include <bridge.hpp>
+
+namespace merkle {
+
+   using eosio::checksum256;
+
+   // canonical pair flags, matching the block and action merkle trees produced by nodeos
+   static bool is_canonical_left(const checksum256& val) {
+      return (val.extract_as_byte_array()[0] & 0x80) == 0;
+   }
+
+   static checksum256 make_canonical_left(const checksum256& val) {
+      std::array<uint8_t, 32> arr = val.extract_as_byte_array();
+      arr[0] &= 0x7f;
+      return checksum256(arr);
+   }
+
+   static checksum256 make_canonical_right(const checksum256& val) {
+      std::array<uint8_t, 32> arr = val.extract_as_byte_array();
+      arr[0] |= 0x80;
+      return checksum256(arr);
+   }
+
+   static checksum256 hash_pair(const checksum256& left, const checksum256& right) {
+      std::array<uint8_t, 64> buf;
+      std::array<uint8_t, 32> l = left.extract_as_byte_array();
+      std::array<uint8_t, 32> r = right.extract_as_byte_array();
+      std::copy(l.cbegin(), l.cend(), buf.begin());
+      std::copy(r.cbegin(), r.cend(), buf.begin() + 32);
+      return eosio::sha256((const char*)buf.data(), buf.size());
+   }
+
+   // parent of two sibling nodes of the block and action merkle trees
+   static checksum256 hash_canonical(const checksum256& left, const checksum256& right) {
+      return hash_pair(make_canonical_left(left), make_canonical_right(right));
+   }
+
+   // walks a proof path from a leaf up to the root, using the canonical flag of each node to tell which side it is on
+   static checksum256 compute_root(const std::vector<checksum256>& path, const checksum256& leaf) {
+      checksum256 current = leaf;
+      for (const checksum256& node : path) {
+         if (is_canonical_left(node)) current = hash_canonical(node, current);
+         else current = hash_canonical(current, node);
+      }
+      return current;
+   }
+
+   // root of a tree built the way nodeos builds the action merkle tree of a block, so paths from it verify with compute_root
+   static checksum256 tree_root(std::vector<checksum256> nodes) {
+      if (nodes.empty()) return checksum256();
+      while (nodes.size() > 1) {
+         if (nodes.size() % 2) nodes.push_back(nodes.back());
+         for (size_t i = 0; i < nodes.size() / 2; i++) {
+            nodes[i] = hash_canonical(nodes[2 * i], nodes[2 * i + 1]);
+         }
+         nodes.resize(nodes.size() / 2);
+      }
+      return nodes[0];
+   }
+
+   // action digest as committed to by an action receipt before the ACTION_RETURN_VALUE protocol feature
+   static checksum256 legacy_action_digest(const eosio::action& act) {
+      std::vector<char> serialized = eosio::pack(act);
+      return eosio::sha256(serialized.data(), serialized.size());
+   }
+
+   // action digest as committed to by an action receipt once ACTION_RETURN_VALUE is activated
+   static checksum256 action_digest(const eosio::action& act, const std::vector<char>& returnvalue) {
+      std::vector<char> base = eosio::pack(std::make_tuple(act.account, act.name, act.authorization));
+      std::vector<char> rhs = eosio::pack(std::make_tuple(act.data, returnvalue));
+      return hash_pair(eosio::sha256(base.data(), base.size()), eosio::sha256(rhs.data(), rhs.size()));
+   }
+
+   static checksum256 receipt_digest(const bridge::actreceipt& receipt) {
+      std::vector<char> serialized = eosio::pack(receipt);
+      return eosio::sha256(serialized.data(), serialized.size());
+   }
+
+   // verifies that actionproof is included under action_mroot of a block that has already been proven by the bridge
+   static void check_action_proof(const checksum256& action_mroot, const bridge::actionproof& actionproof) {
+      eosio::check(actionproof.receipt.receiver == actionproof.action.account, "action receipt must be from the action account");
+      eosio::check(actionproof.receipt.act_digest == action_digest(actionproof.action, actionproof.returnvalue)
+                   || actionproof.receipt.act_digest == legacy_action_digest(actionproof.action), "action digest does not match receipt");
+      eosio::check(compute_root(actionproof.amproofpath, receipt_digest(actionproof.receipt)) == action_mroot, "invalid action merkle proof path");
+   }
+
+}
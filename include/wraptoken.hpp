@@ -4,10 +4,19 @@
 #include <eosio/eosio.hpp>
 #include <eosio/singleton.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <optional>
 #include <string>
+#include <type_traits>
 
+#include <blockheaders.hpp>
 #include <bridge.hpp>
+#include <compactproof.hpp>
 #include <eosio.token.hpp>
+#include <merkle.hpp>
 
 namespace eosiosystem {
    class system_contract;
@@ -20,7 +29,7 @@ namespace eosio {
    class [[eosio::contract("wraptoken")]] wraptoken : public contract {
       private:
 
-         // for bridge communication
+         // proofs used to be handed to the bridge through these singletons, kept so stale rows can be cleared
          TABLE lpstruct {
 
             uint64_t id;
@@ -31,7 +40,7 @@ namespace eosio {
 
             EOSLIB_SERIALIZE( lpstruct, (id)(lp) )
 
-         } _light_proof_obj;
+         };
 
          TABLE hpstruct {
 
@@ -43,14 +52,11 @@ namespace eosio {
 
             EOSLIB_SERIALIZE( hpstruct, (id)(hp) )
 
-         } _heavy_proof_obj;
+         };
 
          using lptable = eosio::singleton<"lightproof"_n, lpstruct>;
          using hptable = eosio::singleton<"heavyproof"_n, hpstruct>;
 
-         lptable _light_proof;
-         hptable _heavy_proof;
-
 
          // structure used for globals - see `init` action for documentation
          struct [[eosio::table]] global {
@@ -92,11 +98,111 @@ namespace eosio {
 
          };
 
-         void add_or_assert(const bridge::actionproof& actionproof, const name& payer);
-         void sub_balance( const name& owner, const asset& value );
-         void add_balance( const name& owner, const asset& value, const name& ram_payer );
-         void _issue(const name& prover, const bridge::actionproof actionproof);
-         void _cancel(const name& prover, const bridge::actionproof actionproof);
+         // structure used for retaining action receipt digests of accepted proven actions within the replay protection window,
+         // keyed by the leading 64 bits of the digest (see `receipt_key`)
+         struct [[eosio::table]] receipt {
+
+           uint64_t                        id;
+           checksum256                     receipt_digest;
+           time_point_sec                  block_time;
+
+           uint64_t primary_key()const { return id; }
+           uint64_t by_block_time()const { return block_time.sec_since_epoch(); }
+
+           EOSLIB_SERIALIZE( receipt, (id)(receipt_digest)(block_time))
+
+         };
+
+         // structure used for operational settings - see `setreplay`, `setissuemode` and `setoutbox` actions for documentation
+         struct [[eosio::table]] settings {
+            uint32_t        replay_window = 0;      // seconds, 0 until `setreplay` turns replay protection windows on
+            uint32_t        prune_count = 4;
+            time_point_sec  legacy_time;    // all rows in the legacy `processed` table prove blocks older than this
+            time_point_sec  pruned_until;   // newest block time erased by pruning, proofs at or before it are rejected
+            bool            direct_issue = false;
+            bool            outbox = false;
+            uint32_t        commit_interval = 0;
+            uint64_t        outbox_next_id = 0; // id of the next retirement queued in the outbox
+            uint64_t        epoch = 0;          // number of the next outbox commitment
+            time_point_sec  last_commit;
+            uint32_t        root_cache_ttl = 0; // seconds a verified block root stays usable by `issuec` and `cancelc`, 0 disables the cache
+         };
+
+         // structure used for the action merkle root of a block already verified by the bridge
+         struct [[eosio::table]] blockroot {
+            uint64_t        id;
+            checksum256     chain_id;
+            checksum256     block_id;
+            checksum256     action_mroot;
+            time_point_sec  block_time;
+            time_point_sec  expires;
+
+            uint64_t primary_key()const { return id; }
+            uint64_t by_expiry()const { return expires.sec_since_epoch(); }
+
+            EOSLIB_SERIALIZE( blockroot, (id)(chain_id)(block_id)(action_mroot)(block_time)(expires))
+
+         };
+
+         static uint64_t blockroot_key(const checksum256& chain_id, const checksum256& block_id) {
+            std::vector<char> serialized = pack(std::make_tuple(chain_id, block_id));
+            std::array<uint8_t, 32> arr = sha256(serialized.data(), serialized.size()).extract_as_byte_array();
+            uint64_t key = 0;
+            memcpy(&key, arr.data(), sizeof(key));
+            return key;
+         }
+
+         // structure used for a native chain, wraplock contract and token contract served in addition to the pair set by `init`
+         struct [[eosio::table]] pairing {
+            uint64_t      id;
+            checksum256   chain_id;
+            name          wraplock_contract;
+            name          token_contract;
+
+            uint64_t primary_key()const { return id; }
+            checksum256 by_key()const { return pair_key(chain_id, wraplock_contract, token_contract); }
+
+            EOSLIB_SERIALIZE( pairing, (id)(chain_id)(wraplock_contract)(token_contract))
+
+         };
+
+         // structure used to route a wrapped symbol to the pair it is locked on, symbols without a route use the `init` pair
+         struct [[eosio::table]] route {
+            symbol_code   sym;
+            uint64_t      pair_id;
+
+            uint64_t primary_key()const { return sym.raw(); }
+
+            EOSLIB_SERIALIZE( route, (sym)(pair_id))
+
+         };
+
+         static checksum256 pair_key(const checksum256& chain_id, const name& wraplock_contract, const name& token_contract) {
+            std::vector<char> serialized = pack(std::make_tuple(chain_id, wraplock_contract, token_contract));
+            return sha256(serialized.data(), serialized.size());
+         }
+
+         // number of consecutive keys a receipt digest may occupy when its leading 64 bits collide with stored digests
+         static constexpr uint64_t RECEIPT_PROBES = 8;
+
+         static uint64_t receipt_key(const checksum256& digest) {
+            std::array<uint8_t, 32> arr = digest.extract_as_byte_array();
+            uint64_t key = 0;
+            memcpy(&key, arr.data(), sizeof(key));
+            return std::min(key, std::numeric_limits<uint64_t>::max() - RECEIPT_PROBES);
+         }
+
+         class context;
+
+         checksum256 add_or_assert(context& ctx, const bridge::actionproof& actionproof, const name& payer, const time_point_sec& block_time);
+         void add_receipt(const checksum256& digest, const time_point_sec& block_time, const name& payer);
+         const receipt* find_receipt(const checksum256& digest) const;
+         void prune_receipts(context& ctx, uint32_t max_rows);
+         void cache_block_root(context& ctx, const checksum256& chain_id, const blockheaders::memo& header, const name& payer);
+         const blockroot& cached_block_root(const checksum256& chain_id, const checksum256& block_id);
+         void set_route(const symbol_code& sym, const uint64_t pair_id);
+         void sub_balance( context& ctx, const name& owner, const asset& value );
+         void add_balance( context& ctx, const name& owner, const asset& value, const name& ram_payer );
 
       public:
          using contract::contract;
@@ -108,6 +214,107 @@ namespace eosio {
            name             beneficiary;
          };
 
+         // structure used for a single recipient of the `transfermany` action
+         struct payout {
+           name             to;
+           asset            quantity;
+         };
+
+         // structure used for a single beneficiary of the `retirebatch` action
+         struct retirement {
+           asset            quantity;
+           name             beneficiary;
+         };
+
+         // structures used by the read-only query actions
+         struct balancequery {
+           name             owner;
+           symbol_code      sym;
+         };
+
+         struct balanceresult {
+           name             owner;
+           symbol_code      sym;
+           bool             exists;
+           asset            balance;
+         };
+
+         struct supplyresult {
+           symbol_code      sym;
+           bool             exists;
+           asset            supply;
+           asset            max_supply;
+         };
+
+         struct receiptstatus {
+           checksum256      digest;
+           bool             processed;
+           bool             legacy;         // recorded in the `processed` table of earlier versions, which has no block time
+           time_point_sec   block_time;
+         };
+
+         // structures returned by the proof, retire and transfer actions, so the outcome can be read from the action trace
+         struct issueresult {
+           checksum256      receipt_digest;   // digest recorded for replay protection
+           name             beneficiary;
+           asset            quantity;
+           asset            supply;           // wrapped supply after the issue
+           asset            balance;          // beneficiary balance once the issued quantity has reached it
+         };
+
+         struct cancelresult {
+           checksum256      receipt_digest;   // digest recorded for replay protection
+           xfer             refund;           // emitted to return the locked tokens on the native chain
+         };
+
+         struct retireresult {
+           asset                     supply;         // wrapped supply after the retirement
+           asset                     balance;        // owner balance after the retirement
+           std::optional<uint64_t>   outbox_id;      // set when the xfer was queued in the outbox instead of emitted
+         };
+
+         struct transferresult {
+           asset            from_balance;
+           asset            to_balance;
+         };
+
+         // verdict codes returned by the `validate` read-only action, codes are never reused when checks are added
+         static constexpr uint8_t VERDICT_OK                = 0;
+         static constexpr uint8_t VERDICT_NOT_INITIALIZED   = 1;
+         static constexpr uint8_t VERDICT_DISABLED          = 2;
+         static constexpr uint8_t VERDICT_CANCEL_TOO_EARLY  = 3;
+         static constexpr uint8_t VERDICT_WRONG_ACTION      = 4;
+         static constexpr uint8_t VERDICT_INVALID_SYMBOL    = 5;
+         static constexpr uint8_t VERDICT_WRONG_CHAIN       = 6;
+         static constexpr uint8_t VERDICT_WRONG_ACCOUNT     = 7;
+         static constexpr uint8_t VERDICT_WRONG_CONTRACT    = 8;
+         static constexpr uint8_t VERDICT_OUTSIDE_WINDOW    = 9;
+         static constexpr uint8_t VERDICT_PRUNED            = 10;
+         static constexpr uint8_t VERDICT_ALREADY_PROVED    = 11;
+         static constexpr uint8_t VERDICT_INVALID_QUANTITY  = 12;
+         static constexpr uint8_t VERDICT_PRECISION         = 13;
+         static constexpr uint8_t VERDICT_SUPPLY_EXCEEDED   = 14;
+         static constexpr uint8_t VERDICT_NOT_REGISTERED    = 15;
+         static constexpr uint8_t VERDICT_MALFORMED_XFER    = 16;
+         static constexpr uint8_t VERDICT_NO_BENEFICIARY    = 17;
+
+         struct verdict {
+           uint8_t          code;
+           string           reason;           // the error message the issue or cancel action would fail with
+           checksum256      receipt_digest;
+         };
+
+         // structure used for a retirement queued in the outbox until the next `commit`
+         struct [[eosio::table]] outboxentry {
+           uint64_t         id;
+           xfer             transfer;
+
+           uint64_t primary_key()const { return id; }
+
+           EOSLIB_SERIALIZE( outboxentry, (id)(transfer))
+
+         };
+
 
          /**
           * Allows contract account to set which chains and associated contracts are used for all interchain transfers.
@@ -123,47 +330,142 @@ namespace eosio {
 
          /**
           * Allows `prover` account to issue wrapped tokens and send them to the beneficiary indentified in the `actionproof`.
+          * Returns the recorded receipt digest, the new supply and the beneficiary balance once the tokens have reached it.
+          * In direct issue mode (see `setissuemode`) the beneficiary is notified of this action, which is the indexable record of the credit.
           *
           * @param prover - the calling account whose ram is used for storing the action receipt digest to prevent replay attacks
           * @param blockproof - the heavy proof data structure
           * @param actionproof - the proof structure for the `emitxfer` action associated with the locking transfer action on the native chain
           */
          [[eosio::action]]
-         void issuea(const name& prover, const bridge::heavyproof blockproof, const bridge::actionproof actionproof);
+         issueresult issuea(const name& prover, const bridge::heavyproof& blockproof, const bridge::actionproof& actionproof);
 
          /**
           * Allows `prover` account to issue wrapped tokens and send them to the beneficiary indentified in the `actionproof`.
+          * Returns the recorded receipt digest, the new supply and the beneficiary balance once the tokens have reached it.
+          * In direct issue mode (see `setissuemode`) the beneficiary is notified of this action, which is the indexable record of the credit.
           *
           * @param prover - the calling account whose ram is used for storing the action receipt digest to prevent replay attacks
           * @param blockproof - the light proof data structure
           * @param actionproof - the proof structure for the `emitxfer` action associated with the locking transfer action on the native chain
           */
          [[eosio::action]]
-         void issueb(const name& prover, const bridge::lightproof blockproof, const bridge::actionproof actionproof);
+         issueresult issueb(const name& prover, const bridge::lightproof& blockproof, const bridge::actionproof& actionproof);
 
          /**
           * Allows `prover` account to cancel a token transfer and return them to the beneficiary indentified in the `actionproof`.
+          * Returns the recorded receipt digest and the `xfer` emitted to return the tokens.
           *
           * @param prover - the calling account whose ram is used for storing the action receipt digest to prevent replay attacks
           * @param blockproof - the heavy proof data structure
           * @param actionproof - the proof structure for the `emitxfer` action associated with the locking transfer action on the native chain
           */
          [[eosio::action]]
-         void cancela(const name& prover, const bridge::heavyproof blockproof, const bridge::actionproof actionproof);
+         cancelresult cancela(const name& prover, const bridge::heavyproof& blockproof, const bridge::actionproof& actionproof);
 
          /**
           * Allows `prover` account to cancel a token transfer and return them to the beneficiary indentified in the `actionproof`.
+          * Returns the recorded receipt digest and the `xfer` emitted to return the tokens.
           *
           * @param prover - the calling account whose ram is used for storing the action receipt digest to prevent replay attacks
           * @param blockproof - the light proof data structure
           * @param actionproof - the proof structure for the `emitxfer` action associated with the locking transfer action on the native chain
           */
          [[eosio::action]]
-         void cancelb(const name& prover, const bridge::lightproof blockproof, const bridge::actionproof actionproof);
+         cancelresult cancelb(const name& prover, const bridge::lightproof& blockproof, const bridge::actionproof& actionproof);
+
+         /**
+          * Allows `prover` account to issue wrapped tokens for several locks proven against the same block. The block proof is verified
+          * once by the bridge together with the first action proof, the remaining action proofs are checked against its action merkle root.
+          *
+          * @param prover - the calling account whose ram is used for storing the action receipt digests to prevent replay attacks
+          * @param blockproof - the heavy proof data structure
+          * @param actionproofs - the proof structures for the `emitxfer` actions included in the proven block
+          */
+         [[eosio::action]]
+         void issuebatcha(const name& prover, const bridge::heavyproof& blockproof, const std::vector<bridge::actionproof>& actionproofs);
+
+         /**
+          * Allows `prover` account to issue wrapped tokens for several locks proven against the same block. The block proof is verified
+          * once by the bridge together with the first action proof, the remaining action proofs are checked against its action merkle root.
+          *
+          * @param prover - the calling account whose ram is used for storing the action receipt digests to prevent replay attacks
+          * @param blockproof - the light proof data structure
+          * @param actionproofs - the proof structures for the `emitxfer` actions included in the proven block
+          */
+         [[eosio::action]]
+         void issuebatchb(const name& prover, const bridge::lightproof& blockproof, const std::vector<bridge::actionproof>& actionproofs);
+
+         /**
+          * Allows `prover` account to cancel several token transfers proven against the same block and return them to their owners.
+          *
+          * @param prover - the calling account whose ram is used for storing the action receipt digests to prevent replay attacks
+          * @param blockproof - the heavy proof data structure
+          * @param actionproofs - the proof structures for the `emitxfer` actions included in the proven block
+          */
+         [[eosio::action]]
+         void cancelbatcha(const name& prover, const bridge::heavyproof& blockproof, const std::vector<bridge::actionproof>& actionproofs);
+
+         /**
+          * Allows `prover` account to cancel several token transfers proven against the same block and return them to their owners.
+          *
+          * @param prover - the calling account whose ram is used for storing the action receipt digests to prevent replay attacks
+          * @param blockproof - the light proof data structure
+          * @param actionproofs - the proof structures for the `emitxfer` actions included in the proven block
+          */
+         [[eosio::action]]
+         void cancelbatchb(const name& prover, const bridge::lightproof& blockproof, const std::vector<bridge::actionproof>& actionproofs);
+
+         /**
+          * Allows `prover` account to issue wrapped tokens against a block verified by the bridge within the last `root_cache_ttl`
+          * seconds. Only the action proof is checked, against the cached action merkle root, and no bridge action is sent.
+          *
+          * @param prover - the calling account whose ram is used for storing the action receipt digests to prevent replay attacks
+          * @param chain_id - the id of the chain the block belongs to
+          * @param block_id - the id of the block, as cached by an earlier issue or cancel action
+          * @param actionproof - the proof structure for the `emitxfer` action associated with the locking transfer action on the native chain
+          */
+         [[eosio::action]]
+         issueresult issuec(const name& prover, const checksum256& chain_id, const checksum256& block_id, const bridge::actionproof& actionproof);
+
+         /**
+          * Allows `prover` account to cancel a token transfer against a block verified by the bridge within the last `root_cache_ttl`
+          * seconds. Only the action proof is checked, against the cached action merkle root, and no bridge action is sent.
+          *
+          * @param prover - the calling account whose ram is used for storing the action receipt digests to prevent replay attacks
+          * @param chain_id - the id of the chain the block belongs to
+          * @param block_id - the id of the block, as cached by an earlier issue or cancel action
+          * @param actionproof - the proof structure for the `emitxfer` action associated with the locking transfer action on the native chain
+          */
+         [[eosio::action]]
+         cancelresult cancelc(const name& prover, const checksum256& chain_id, const checksum256& block_id, const bridge::actionproof& actionproof);
+
+         /**
+          * Same as `issuea`, with the heavy proof in the compact encoding of `compactproof.hpp`. It is expanded into the full heavy
+          * proof before it is checked and handed to the bridge.
+          *
+          * @param prover - the calling account whose ram is used for storing the action receipt digests to prevent replay attacks
+          * @param blockproof - the compact heavy proof data structure
+          * @param actionproof - the proof structure for the `emitxfer` action associated with the locking transfer action on the native chain
+          */
+         [[eosio::action]]
+         issueresult issued(const name& prover, const compactproof::compactheavyproof& blockproof, const bridge::actionproof& actionproof);
+
+         /**
+          * Same as `cancela`, with the heavy proof in the compact encoding of `compactproof.hpp`. It is expanded into the full heavy
+          * proof before it is checked and handed to the bridge.
+          *
+          * @param prover - the calling account whose ram is used for storing the action receipt digests to prevent replay attacks
+          * @param blockproof - the compact heavy proof data structure
+          * @param actionproof - the proof structure for the `emitxfer` action associated with the locking transfer action on the native chain
+          */
+         [[eosio::action]]
+         cancelresult canceld(const name& prover, const compactproof::compactheavyproof& blockproof, const bridge::actionproof& actionproof);
 
          /**
           * Allows `owner` account to retire the `quantity` of wrapped tokens and calls the `emitxfer` action inline so that can be used
           * as the basis for a proof of locking for the withdraw actions on the native chain.
+          * Returns the new supply, the remaining owner balance and the outbox id when the `xfer` was queued.
           *
           * @param from - the owner of the tokens to be sent to the native token chain
           * @param to - this contract account
@@ -171,14 +473,49 @@ namespace eosio {
           * @param memo - the beneficiary account on the native token chain
           */
          [[eosio::action]]
-         void retire(const name& owner,  const asset& quantity, const name& beneficiary);
+         retireresult retire(const name& owner,  const asset& quantity, const name& beneficiary);
+
+         /**
+          * Allows `owner` account to retire wrapped tokens for several beneficiaries at once, possibly across symbols. Each touched
+          * supply and the owner balance of each symbol are updated once, and one `emitxfer` is sent per beneficiary. All of them are
+          * included in the same block, so the withdrawals on the native chain can be proven in a batch against a single block proof.
+          *
+          * @param owner - the owner of the tokens to be sent to the native token chain
+          * @param retirements - the quantities to be sent and the beneficiary account on the native token chain of each
+          */
+         [[eosio::action]]
+         void retirebatch(const name& owner, const std::vector<retirement>& retirements);
 
 
+         /**
+          * Allows `from` account to send wrapped tokens to `to`. Returns the balances of both accounts after the transfer.
+          *
+          * @param from - the account sending the tokens
+          * @param to - the account receiving the tokens
+          * @param quantity - the asset to be sent
+          * @param memo - the memo attached to the transfer
+          */
+         [[eosio::action]]
+         transferresult transfer( const name&    from,
+                                  const name&    to,
+                                  const asset&   quantity,
+                                  const string&  memo );
+
+         /**
+          * Allows `from` account to send wrapped tokens to several accounts in one action. The sender is authorized and debited once
+          * per symbol, and every recipient is notified of the action.
+          *
+          * No `transfer` action is sent per payout: the `transfermany` notification is the only record a recipient sees, so wallets
+          * and indexers must decode `transfermany` to show these incoming transfers.
+          *
+          * @param from - the account sending the tokens
+          * @param payouts - the recipients and the quantity each of them receives
+          * @param memo - the memo attached to every payout
+          */
          [[eosio::action]]
-         void transfer( const name&    from,
-                        const name&    to,
-                        const asset&   quantity,
-                        const string&  memo );
+         void transfermany( const name&                   from,
+                            const std::vector<payout>&    payouts,
+                            const string&                 memo );
   
          [[eosio::action]]
          void open( const name& owner, const symbol& symbol, const name& ram_payer );
@@ -190,6 +527,170 @@ namespace eosio {
          [[eosio::action]]
          void emitxfer(const wraptoken::xfer& xfer);
 
+         /**
+          * Commitment over the retirements with ids `first_id` to `first_id + count - 1`, sent inline by `commit`. Each leaf is the
+          * sha256 of the packed (id, xfer) pair and the tree is built like the action merkle tree of a block, so a withdrawal on the
+          * native chain is proven with one proof of this action plus a merkle path from the leaf to `root`.
+          *
+          * @param epoch - the sequence number of the commitment
+          * @param first_id - the id of the first retirement included
+          * @param count - the number of retirements included
+          * @param root - the merkle root over the included retirements
+          */
+         [[eosio::action]]
+         void emitroot(const uint64_t epoch, const uint64_t first_id, const uint64_t count, const checksum256& root);
+
+         /**
+          * Allows any account to close the current outbox epoch. Up to `max_rows` queued retirements are erased and committed to by a
+          * single inline `emitroot`.
+          *
+          * @param max_rows - the maximum number of retirements included in the commitment
+          */
+         [[eosio::action]]
+         void commit(const uint32_t max_rows);
+
+         /**
+          * Allows contract account to queue retirements in the outbox instead of sending an `emitxfer` for each one. Queued
+          * retirements are committed to by `commit`, which may be called at most once every `commit_interval` seconds.
+          *
+          * @param enabled - true to queue retirements in the outbox, false to send an `emitxfer` for each one
+          * @param commit_interval - the minimum number of seconds between two commitments
+          */
+         [[eosio::action]]
+         void setoutbox(const bool enabled, const uint32_t commit_interval);
+
+         /**
+          * Allows contract account to cache the action merkle roots of blocks verified by the bridge, so that further locks in the
+          * same block can be issued or cancelled with `issuec` and `cancelc`. Cached roots are paid for by the prover of the block and
+          * erased by later issue and cancel actions once they expire.
+          *
+          * @param ttl - the number of seconds a cached root can be used, 0 to stop caching roots
+          */
+         [[eosio::action]]
+         void setrootcache(const uint32_t ttl);
+
+         /**
+          * Allows contract account to serve another native chain, wraplock contract and token contract from this deployment. All
+          * pairs share the bridge contract, the replay protection and the action context of a proof action.
+          *
+          * @param chain_id - the id of the chain hosting the native tokens
+          * @param wraplock_contract - the wraplock contract on the native token chain
+          * @param token_contract - the token contract on the native chain being enabled for interchain transfers
+          */
+         [[eosio::action]]
+         void addpair(const checksum256& chain_id, const name& wraplock_contract, const name& token_contract);
+
+         /**
+          * Allows contract account to route a wrapped symbol to one of the pairs added by `addpair`. Issues and cancels of the symbol
+          * must be proven against that pair and retirements are sent to it. A symbol is routed to a single pair, and cannot be rerouted
+          * while wrapped tokens of it are outstanding.
+          *
+          * @param sym - the wrapped symbol
+          * @param pair_id - the id of the pair, or 0 to route the symbol to the pair set by `init`
+          */
+         [[eosio::action]]
+         void setroute(const symbol_code& sym, const uint64_t pair_id);
+
+         /**
+          * Allows contract account to register a wrapped symbol before it can be issued. Registration fixes the precision and the
+          * maximum supply of the symbol and routes it to a pair, so issues only look the symbol up and never create rows. Calling
+          * it again for a registered symbol updates its maximum supply, which cannot go below the outstanding supply, and its route.
+          *
+          * @param max_supply - the maximum supply, in the precision of the wrapped symbol
+          * @param pair_id - the id of the pair the symbol is routed to, or 0 for the pair set by `init`
+          */
+         [[eosio::action]]
+         void regsymbol(const asset& max_supply, const uint64_t pair_id);
+
+         /**
+          * Read-only action returning the balances of many (owner, symbol) pairs, in query order.
+          *
+          * @param queries - the owners and symbols to look up
+          */
+         [[eosio::action, eosio::read_only]]
+         std::vector<balanceresult> getbalances(const std::vector<balancequery>& queries);
+
+         /**
+          * Read-only action returning the supply and maximum supply of many wrapped symbols, in query order.
+          *
+          * @param syms - the symbols to look up
+          */
+         [[eosio::action, eosio::read_only]]
+         std::vector<supplyresult> getsupplies(const std::vector<symbol_code>& syms);
+
+         /**
+          * Read-only action returning whether each action receipt digest has already been used to issue or cancel, in query order.
+          * Digests of blocks at or before the `pruned_until` setting may have been erased and are rejected regardless.
+          *
+          * @param digests - the sha256 digests of the packed action receipts to look up
+          */
+         [[eosio::action, eosio::read_only]]
+         std::vector<receiptstatus> getreceipts(const std::vector<checksum256>& digests);
+
+         /**
+          * Read-only action running the checks of an issue or cancel that do not involve the bridge, so relayers can drop proofs that
+          * would fail before paying for a transaction. The block proof itself is not checked, only the block time and chain it claims.
+          * Returns the code of the first failing check, or `VERDICT_OK`, along with the receipt digest the action would record.
+          *
+          * @param cancel - whether to validate a cancel rather than an issue
+          * @param chain_id - the id of the chain the proven block belongs to
+          * @param block_time - the timestamp of the proven block
+          * @param actionproof - the proof structure for the `emitxfer` action associated with the locking transfer action on the native chain
+          */
+         [[eosio::action, eosio::read_only]]
+         verdict validate(const bool cancel, const checksum256& chain_id, const time_point_sec& block_time, const bridge::actionproof& actionproof);
+
+         /**
+          * Allows contract account to choose how issued tokens reach the beneficiary. By default they are issued to the contract account
+          * and sent on with an inline `transfer`. In direct mode the beneficiary balance is credited by the issue action itself, without
+          * any inline action, and the beneficiary is notified of the issue action. That issue action is then the only record of the
+          * credit: wallets and indexers that only follow `transfer` do not see it, and should read the beneficiary and quantity from
+          * the `issueresult` return value of the single issue actions received by the beneficiary.
+          *
+          * @param direct - true to credit beneficiaries directly, false to issue through an inline `transfer`
+          */
+         [[eosio::action]]
+         void setissuemode(const bool direct);
+
+         /**
+          * Allows contract account to erase the `lightproof` and `heavyproof` singletons written by earlier versions of the contract.
+          */
+         [[eosio::action]]
+         void clearproofs();
+
+         /**
+          * Allows contract account to configure replay protection. Proofs of blocks older than `replay_window` seconds are rejected,
+          * which allows receipt digests of such blocks to be erased and their ram refunded. The window is off until this action is
+          * called, and every receipt digest is kept.
+          *
+          * Once a window is set, a lock older than the window can never be issued or cancelled, as both go through the same
+          * replay protection: its tokens stay locked on the native chain. The window must leave relayers ample time to prove every
+          * lock, including locks to accounts that do not exist which can only be cancelled. Setting the window back to 0 turns the
+          * age check off again, but blocks at or before the newest pruned block time stay rejected.
+          *
+          * @param replay_window - the maximum age in seconds of a proven block, 0 to accept proofs of any age
+          * @param prune_count - the maximum number of expired receipt digests erased by each issue and cancel action
+          */
+         [[eosio::action]]
+         void setreplay(const uint32_t replay_window, const uint32_t prune_count);
+
+         /**
+          * Allows contract account to move up to `max_rows` receipt digests from the legacy `processed` table into the `receipts` table.
+          * Migrated rows are charged to the contract account and recorded with the block time of the first replay protection configuration.
+          *
+          * @param max_rows - the maximum number of rows to migrate
+          */
+         [[eosio::action]]
+         void migrate(const uint32_t max_rows);
+
+         /**
+          * Allows any account to erase up to `max_rows` expired receipt digests, refunding their ram to the original provers.
+          *
+          * @param max_rows - the maximum number of rows to erase
+          */
+         [[eosio::action]]
+         void prune(const uint32_t max_rows);
+
          /**
           * Disable all user actions on the contract.
           */
@@ -222,9 +723,10 @@ namespace eosio {
          }
 
          using transfer_action = action_wrapper<"transfer"_n, &token::transfer>;
-         using heavyproof_action = action_wrapper<"checkproofb"_n, &bridge::checkproofb>;
-         using lightproof_action = action_wrapper<"checkproofc"_n, &bridge::checkproofc>;
+         using heavyproof_action = action_wrapper<"checkproofe"_n, &bridge::checkproofe>;
+         using lightproof_action = action_wrapper<"checkprooff"_n, &bridge::checkprooff>;
          using emitxfer_action = action_wrapper<"emitxfer"_n, &wraptoken::emitxfer>;
+         using emitroot_action = action_wrapper<"emitroot"_n, &wraptoken::emitroot>;
 
          typedef eosio::multi_index< "accounts"_n, account > accounts;
          typedef eosio::multi_index< "stat"_n, currency_stats > stats;
@@ -233,18 +735,108 @@ namespace eosio {
          typedef eosio::multi_index< "processed"_n, processed,
             indexed_by<"digest"_n, const_mem_fun<processed, checksum256, &processed::by_digest>>> processedtable;
 
+         // the blocktime index is what prune_receipts walks, so every receipt stored writes two index entries
+         typedef eosio::multi_index< "receipts"_n, receipt,
+            indexed_by<"blocktime"_n, const_mem_fun<receipt, uint64_t, &receipt::by_block_time>>> receiptstable;
+
+         typedef eosio::multi_index< "outbox"_n, outboxentry > outboxtable;
+
+         typedef eosio::multi_index< "pairs"_n, pairing,
+            indexed_by<"pairkey"_n, const_mem_fun<pairing, checksum256, &pairing::by_key>>> pairstable;
+
+         typedef eosio::multi_index< "routes"_n, route > routestable;
+
+         typedef eosio::multi_index< "blockroots"_n, blockroot,
+            indexed_by<"expiry"_n, const_mem_fun<blockroot, uint64_t, &blockroot::by_expiry>>> blockrootstable;
+
          using globaltable = eosio::singleton<"global"_n, global>;
+         using settingstable = eosio::singleton<"settings"_n, settings>;
 
          globaltable global_config;
+         settingstable settings_config;
 
          processedtable _processedtable;
+         receiptstable _receiptstable;
+         outboxtable _outboxtable;
+         pairstable _pairstable;
+         routestable _routestable;
+         blockrootstable _blockrootstable;
+
+      private:
+
+         issueresult _issue(context& ctx, const name& prover, const checksum256& chain_id, const bridge::actionproof& actionproof, const time_point_sec& block_time);
+         cancelresult _cancel(context& ctx, const name& prover, const checksum256& chain_id, const bridge::actionproof& actionproof, const time_point_sec& block_time);
+
+         // shared body of the issue and cancel actions taking a heavy or light block proof, the single and batch actions of a
+         // proof kind and operation share one instantiation. `block_id` is the id of the proven block when it is already known.
+         template <bool cancel, typename Proof>
+         std::conditional_t<cancel, cancelresult, issueresult> _prove(const name& prover, const Proof& blockproof, const bridge::actionproof* actionproofs, size_t count,
+                                                                      const std::optional<checksum256>& block_id = std::nullopt);
+
+         std::optional<uint64_t> emit_retirement(context& ctx, const name& owner, const asset& quantity, const name& beneficiary);
+
+         // rows used by a single action. The `global` row is read once, the `settings` row, token stats and balances are read
+         // on first use and kept in memory, and `flush` writes back only the rows that were modified.
+         class context {
+            public:
+
+               struct stats_entry {
+                  stats            table;
+                  currency_stats   row;
+                  bool             exists = false;   // row holds a token, either stored or to be created by flush
+                  bool             stored = false;
+                  bool             dirty = false;
+
+                  stats_entry(const name& self, const symbol_code& sym) : table(self, sym.raw()) {}
+               };
+
+               struct balance_entry {
+                  accounts         table;
+                  account          row;
+                  bool             exists = false;   // row holds a balance, either stored or to be created by flush
+                  bool             stored = false;
+                  bool             dirty = false;
+                  name             ram_payer = same_payer;
+
+                  balance_entry(const name& self, const name& owner) : table(self, owner.value) {}
+               };
+
+               bool     initialized;
+               global   config;
+
+               context(wraptoken& contract);
+
+               settings& params();
+               void set_params_dirty() { _params_dirty = true; }
+
+               stats_entry& stats_for(const symbol_code& sym);
+               const pairing& pair_for(const symbol_code& sym);
+               balance_entry& balance_for(const name& owner, const symbol_code& sym);
+
+               void flush();
+
+            private:
+               wraptoken&                                                  _contract;
+               settings                                                    _params;
+               bool                                                        _params_loaded = false;
+               bool                                                        _params_dirty = false;
+               std::map<uint64_t, stats_entry>                             _stats;
+               std::map<std::pair<uint64_t, uint64_t>, balance_entry>      _balances;
+               std::map<uint64_t, pairing>                                 _pairs;
+         };
+
+      public:
 
          wraptoken( name receiver, name code, datastream<const char*> ds ) :
          contract(receiver, code, ds),
          global_config(_self, _self.value),
+         settings_config(_self, _self.value),
          _processedtable(_self, _self.value),
-         _light_proof(receiver, receiver.value),
-         _heavy_proof(receiver, receiver.value)
+         _receiptstable(_self, _self.value),
+         _outboxtable(_self, _self.value),
+         _pairstable(_self, _self.value),
+         _routestable(_self, _self.value),
+         _blockrootstable(_self, _self.value)
          {
 
          }
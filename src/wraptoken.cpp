@@ -2,28 +2,252 @@
 
 namespace eosio {
 
+// packed size of an xfer: owner, extended_asset (amount, symbol and contract) and beneficiary, all of fixed size
+static constexpr size_t XFER_PACKED_SIZE = 8 + 24 + 8;
 
-//adds a proof to the list of processed proofs (throws an exception if proof already exists)
-void wraptoken::add_or_assert(const bridge::actionproof& actionproof, const name& payer){
+static bool is_xfer_payload(const bridge::actionproof& actionproof)
+{
+    return actionproof.action.data.size() >= XFER_PACKED_SIZE;
+}
+
+// decodes the emitxfer payload in place from the proven action data
+static wraptoken::xfer read_xfer(const bridge::actionproof& actionproof)
+{
+    check(is_xfer_payload(actionproof), "emitxfer payload is malformed");
+
+    datastream<const char*> ds(actionproof.action.data.data(), actionproof.action.data.size());
+    wraptoken::xfer lock_act;
+    ds >> lock_act;
+    return lock_act;
+}
+
+wraptoken::context::context(wraptoken& contract) : _contract(contract) {
+    initialized = contract.global_config.exists();
+    if (initialized) config = contract.global_config.get();
+}
+
+wraptoken::settings& wraptoken::context::params(){
+    if (!_params_loaded) {
+        _params = _contract.settings_config.get_or_default(settings{});
+        _params_loaded = true;
+    }
+    return _params;
+}
+
+wraptoken::context::stats_entry& wraptoken::context::stats_for(const symbol_code& sym){
+    auto [itr, inserted] = _stats.try_emplace(sym.raw(), _contract.get_self(), sym);
+    stats_entry& e = itr->second;
+    if (inserted) {
+        auto row = e.table.find(sym.raw());
+        if (row != e.table.end()) {
+            e.row = *row;
+            e.exists = e.stored = true;
+        }
+    }
+    return e;
+}
 
-    auto pid_index = _processedtable.get_index<"digest"_n>();
+const wraptoken::pairing& wraptoken::context::pair_for(const symbol_code& sym){
+    auto itr = _pairs.find(sym.raw());
+    if (itr != _pairs.end()) return itr->second;
+
+    pairing p{ .id = 0, .chain_id = config.paired_chain_id, .wraplock_contract = config.paired_wraplock_contract, .token_contract = config.paired_token_contract };
+
+    auto r = _contract._routestable.find(sym.raw());
+    if (r != _contract._routestable.end()) p = _contract._pairstable.get(r->pair_id, "routed pair does not exist");
+
+    return _pairs.emplace(sym.raw(), p).first->second;
+}
+
+wraptoken::context::balance_entry& wraptoken::context::balance_for(const name& owner, const symbol_code& sym){
+    auto [itr, inserted] = _balances.try_emplace(std::make_pair(owner.value, sym.raw()), _contract.get_self(), owner);
+    balance_entry& e = itr->second;
+    if (inserted) {
+        auto row = e.table.find(sym.raw());
+        if (row != e.table.end()) {
+            e.row = *row;
+            e.exists = e.stored = true;
+        }
+    }
+    return e;
+}
+
+//writes back the rows modified during the action, the multi_index caches serve the lookups of stored rows
+void wraptoken::context::flush(){
+
+    for (auto& entry : _stats) {
+        stats_entry& e = entry.second;
+        if (!e.dirty) continue;
+        if (e.stored) e.table.modify(e.table.find(entry.first), same_payer, [&]( auto& s ) { s = e.row; });
+        else e.table.emplace(_contract.get_self(), [&]( auto& s ) { s = e.row; });
+        e.stored = true;
+        e.dirty = false;
+    }
+
+    for (auto& entry : _balances) {
+        balance_entry& e = entry.second;
+        if (!e.dirty) continue;
+        if (e.stored) e.table.modify(e.table.find(entry.first.second), e.ram_payer, [&]( auto& a ) { a = e.row; });
+        else e.table.emplace(e.ram_payer, [&]( auto& a ) { a = e.row; });
+        e.stored = true;
+        e.dirty = false;
+    }
+
+    if (_params_dirty) {
+        _contract.settings_config.set(_params, _contract.get_self());
+        _params_dirty = false;
+    }
+
+}
+
+//adds a proof to the list of processed proofs (throws an exception if proof already exists or is outside the replay protection window)
+checksum256 wraptoken::add_or_assert(context& ctx, const bridge::actionproof& actionproof, const name& payer, const time_point_sec& block_time){
+
+    settings& replay = ctx.params();
+
+    uint32_t now = current_time_point().sec_since_epoch();
+
+    // every legacy row was written before the first receipt stored here, so only proofs of older blocks can match one
+    if (replay.legacy_time == time_point_sec()) {
+        replay.legacy_time = time_point_sec(now);
+        ctx.set_params_dirty();
+    }
+
+    // a window of 0 keeps every receipt digest and accepts proofs of any age
+    if (replay.replay_window > 0) {
+        check(uint64_t(block_time.sec_since_epoch()) + replay.replay_window >= now, "proof is older than the replay protection window");
+    }
+    check(block_time > replay.pruned_until, "proof is older than the pruned replay protection records");
 
-    std::vector<char> serializedAction = pack(actionproof.action);
     std::vector<char> serializedReceipt = pack(actionproof.receipt);
-    checksum256 action_digest = sha256(serializedAction.data(), serializedAction.size());
     checksum256 action_receipt_digest = sha256(serializedReceipt.data(), serializedReceipt.size());
 
-    auto p_itr = pid_index.find(action_receipt_digest);
+    // rows recorded before the replay protection window was introduced only cover blocks older than legacy_time
+    if (block_time < replay.legacy_time) {
+        auto legacy_index = _processedtable.get_index<"digest"_n>();
+        check(legacy_index.find(action_receipt_digest) == legacy_index.end(), "action already proved");
+    }
+
+    add_receipt(action_receipt_digest, block_time, payer);
 
-    check(p_itr == pid_index.end(), "action already proved");
+    if (replay.prune_count > 0) prune_receipts(ctx, replay.prune_count);
+
+    return action_receipt_digest;
+
+}
 
-    _processedtable.emplace( payer, [&]( auto& s ) {
-        s.id = _processedtable.available_primary_key();
-        s.receipt_digest = action_receipt_digest;
+//stores a receipt digest under the first free key of its probe range (throws an exception if the digest is already stored)
+void wraptoken::add_receipt(const checksum256& digest, const time_point_sec& block_time, const name& payer){
+
+    uint64_t home = receipt_key(digest);
+    uint64_t key = home;
+
+    // rows are visited in key order, so the first gap left in the range is the free key
+    for (auto itr = _receiptstable.lower_bound(home); itr != _receiptstable.end() && itr->id < home + RECEIPT_PROBES; itr++) {
+        check(itr->receipt_digest != digest, "action already proved");
+        if (itr->id == key) key++;
+    }
+
+    check(key < home + RECEIPT_PROBES, "no free receipt key for digest");
+
+    _receiptstable.emplace( payer, [&]( auto& s ) {
+        s.id = key;
+        s.receipt_digest = digest;
+        s.block_time = block_time;
     });
 
 }
 
+//returns the stored row of a receipt digest, or nullptr if the digest is not stored
+const wraptoken::receipt* wraptoken::find_receipt(const checksum256& digest) const{
+
+    uint64_t home = receipt_key(digest);
+
+    for (auto itr = _receiptstable.lower_bound(home); itr != _receiptstable.end() && itr->id < home + RECEIPT_PROBES; itr++) {
+        if (itr->receipt_digest == digest) return &*itr;
+    }
+
+    return nullptr;
+
+}
+
+//erases up to max_rows receipt digests of blocks outside the replay protection window, oldest first
+void wraptoken::prune_receipts(context& ctx, uint32_t max_rows){
+
+    settings& replay = ctx.params();
+
+    uint32_t now = current_time_point().sec_since_epoch();
+    if (replay.replay_window == 0 || now <= replay.replay_window) return;
+    time_point_sec cutoff(now - replay.replay_window);
+
+    time_point_sec pruned_until = replay.pruned_until;
+
+    auto time_index = _receiptstable.get_index<"blocktime"_n>();
+    auto itr = time_index.begin();
+    while (max_rows > 0 && itr != time_index.end() && itr->block_time < cutoff) {
+        if (itr->block_time > pruned_until) pruned_until = itr->block_time;
+        itr = time_index.erase(itr);
+        max_rows--;
+    }
+
+    // legacy rows carry no block time, they can only go once legacy_time itself has left the window
+    if (replay.legacy_time != time_point_sec() && replay.legacy_time < cutoff) {
+        auto legacy_itr = _processedtable.begin();
+        while (max_rows > 0 && legacy_itr != _processedtable.end()) {
+            if (replay.legacy_time > pruned_until) pruned_until = replay.legacy_time;
+            legacy_itr = _processedtable.erase(legacy_itr);
+            max_rows--;
+        }
+    }
+
+    if (pruned_until != replay.pruned_until) {
+        replay.pruned_until = pruned_until;
+        ctx.set_params_dirty();
+    }
+
+}
+
+// remembers the action merkle root of a block proven in this transaction. The row is only written if the bridge accepts the
+// proof, since a rejection reverts the whole transaction.
+void wraptoken::cache_block_root(context& ctx, const checksum256& chain_id, const blockheaders::memo& header, const name& payer)
+{
+    const uint32_t ttl = ctx.params().root_cache_ttl;
+    if (ttl == 0) return;
+
+    const time_point_sec now(current_time_point());
+
+    // erase a couple of expired roots, refunding their ram to the provers that stored them
+    auto by_expiry = _blockrootstable.get_index<"expiry"_n>();
+    for (int i = 0; i < 2; i++) {
+        auto itr = by_expiry.begin();
+        if (itr == by_expiry.end() || itr->expires > now) break;
+        by_expiry.erase(itr);
+    }
+
+    const checksum256& block_id = header.id();
+    const uint64_t key = blockroot_key(chain_id, block_id);
+
+    // already cached, or a different block sharing the key which then simply stays uncached
+    if (_blockrootstable.find(key) != _blockrootstable.end()) return;
+
+    _blockrootstable.emplace( payer, [&]( auto& r ){
+        r.id = key;
+        r.chain_id = chain_id;
+        r.block_id = block_id;
+        r.action_mroot = header.header().action_mroot;
+        r.block_time = time_point_sec(header.header().timestamp.to_time_point());
+        r.expires = now + ttl;
+    });
+}
+
+const wraptoken::blockroot& wraptoken::cached_block_root(const checksum256& chain_id, const checksum256& block_id)
+{
+    const auto& root = _blockrootstable.get(blockroot_key(chain_id, block_id), "block root is not cached");
+    check(root.chain_id == chain_id && root.block_id == block_id, "block root is not cached");
+    check(root.expires > time_point_sec(current_time_point()), "cached block root has expired");
+    return root;
+}
+
 void wraptoken::init(const checksum256& chain_id, const name& bridge_contract, const checksum256& paired_chain_id, const name& paired_wraplock_contract, const name& paired_token_contract)
 {
     check(!global_config.exists(), "contract already initialized");
@@ -43,183 +267,266 @@ void wraptoken::init(const checksum256& chain_id, const name& bridge_contract, c
 
 }
 
-void wraptoken::_issue(const name& prover, const bridge::actionproof actionproof)
+wraptoken::issueresult wraptoken::_issue(context& ctx, const name& prover, const checksum256& chain_id, const bridge::actionproof& actionproof, const time_point_sec& block_time)
 {
-    auto global = global_config.get();
-
-    wraptoken::xfer lock_act = unpack<wraptoken::xfer>(actionproof.action.data);
-
-    check(actionproof.action.account == global.paired_wraplock_contract, "proof account does not match paired wraplock account");
+    check(actionproof.action.name == "emitxfer"_n, "must provide proof of token locking before issuing");
 
-    add_or_assert(actionproof, prover);
+    const wraptoken::xfer lock_act = read_xfer(actionproof);
 
     auto sym = lock_act.quantity.quantity.symbol;
     check( sym.is_valid(), "invalid symbol name" );
-    //check( memo.size() <= 256, "memo has more than 256 bytes" );
 
-    stats statstable( get_self(), sym.code().raw() );
-    auto existing = statstable.find( sym.code().raw() );
+    // only symbols registered by regsymbol are issued, an unknown symbol can only be cancelled
+    auto& st = ctx.stats_for( sym.code() );
+    check( st.exists, "symbol is not registered" );
 
-    // create if no existing matching symbol exists
-    if (existing == statstable.end()) {
-        statstable.emplace( get_self(), [&]( auto& s ) {
-           s.supply = asset(0, sym);
-           s.max_supply = asset((1LL<<62)-1, sym);
-           s.issuer = get_self();
-        });
-        existing = statstable.find( sym.code().raw() );
-    }
-    
-    check( existing != statstable.end(), "token with symbol does not exist, create token before issue" );
+    const auto& pair = ctx.pair_for( sym.code() );
+    check(chain_id == pair.chain_id, "proof chain does not match paired chain");
+    check(actionproof.action.account == pair.wraplock_contract, "proof account does not match paired wraplock account");
+    check(lock_act.quantity.contract == pair.token_contract, "locked token contract does not match paired token contract");
 
-    check(actionproof.action.name == "emitxfer"_n, "must provide proof of token locking before issuing");
+    const checksum256 digest = add_or_assert(ctx, actionproof, prover, block_time);
 
-    const auto& st = *existing;
+    //check( memo.size() <= 256, "memo has more than 256 bytes" );
 
     check( lock_act.quantity.quantity.is_valid(), "invalid quantity" );
     check( lock_act.quantity.quantity.amount > 0, "must issue positive quantity" );
 
-    check( lock_act.quantity.quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
-    check( lock_act.quantity.quantity.amount <= st.max_supply.amount - st.supply.amount, "quantity exceeds available supply");
+    check( lock_act.quantity.quantity.symbol == st.row.supply.symbol, "symbol precision mismatch" );
+    check( lock_act.quantity.quantity.amount <= st.row.max_supply.amount - st.row.supply.amount, "quantity exceeds available supply");
 
-    statstable.modify( st, same_payer, [&]( auto& s ) {
-       s.supply += lock_act.quantity.quantity;
-    });
+    st.row.supply += lock_act.quantity.quantity;
+    st.dirty = true;
+
+    issueresult result = {
+      .receipt_digest = digest,
+      .beneficiary = lock_act.beneficiary,
+      .quantity = lock_act.quantity.quantity,
+      .supply = st.row.supply
+    };
+
+    if (ctx.params().direct_issue) {
 
-    add_balance( _self, lock_act.quantity.quantity, _self );
+        check( is_account( lock_act.beneficiary ), "to account does not exist");
+
+        // credit beneficiary and let it see the issue action, which is the record of the credit, in its own trace
+        add_balance( ctx, lock_act.beneficiary, lock_act.quantity.quantity, prover );
+        require_recipient( lock_act.beneficiary );
+
+        result.balance = ctx.balance_for( lock_act.beneficiary, sym.code() ).row.balance;
+        return result;
+
+    }
+
+    add_balance( ctx, _self, lock_act.quantity.quantity, _self );
 
     // ensure beneficiary has a balance
-    add_balance( lock_act.beneficiary, asset(0, lock_act.quantity.quantity.symbol), prover );
+    add_balance( ctx, lock_act.beneficiary, asset(0, lock_act.quantity.quantity.symbol), prover );
 
     // transfer to beneficiary
     wraptoken::transfer_action act(_self, permission_level{_self, "active"_n});
     act.send(_self, lock_act.beneficiary, lock_act.quantity.quantity, std::string("") );
-    
+
+    // the inline transfer credits the beneficiary after this action
+    result.balance = ctx.balance_for( lock_act.beneficiary, sym.code() ).row.balance + lock_act.quantity.quantity;
+    return result;
+
 }
 
-// mints the wrapped token, requires heavy block proof and action proof
-void wraptoken::issuea(const name& prover, const bridge::heavyproof blockproof, const bridge::actionproof actionproof)
+wraptoken::cancelresult wraptoken::_cancel(context& ctx, const name& prover, const checksum256& chain_id, const bridge::actionproof& actionproof, const time_point_sec& block_time)
 {
-    require_auth(prover);
+    check(actionproof.action.name == "emitxfer"_n, "must provide proof of token locking before issuing");
 
-    check(global_config.exists(), "contract must be initialized first");
-    auto global = global_config.get();
+    const wraptoken::xfer lock_act = read_xfer(actionproof);
 
-    check(global.enabled == true, "contract has been disabled");
+    auto sym = lock_act.quantity.quantity.symbol;
+    check( sym.is_valid(), "invalid symbol name" );
 
-    check(blockproof.chain_id == global.paired_chain_id, "proof chain does not match paired chain");
+    const auto& pair = ctx.pair_for( sym.code() );
+    check(chain_id == pair.chain_id, "proof chain does not match paired chain");
+    check(actionproof.action.account == pair.wraplock_contract, "proof account does not match paired wraplock account");
+    check(lock_act.quantity.contract == pair.token_contract, "locked token contract does not match paired token contract");
 
-    // check proof against bridge
-    // will fail tx if prove is invalid
-    auto p = _heavy_proof.get_or_create(_self, _heavy_proof_obj);
-    p.hp = blockproof;
-    _heavy_proof.set(p, _self);
-    wraptoken::heavyproof_action checkproof_act(global.bridge_contract, permission_level{_self, "active"_n});
-    checkproof_act.send(_self, actionproof);
+    const checksum256 digest = add_or_assert(ctx, actionproof, prover, block_time);
+
+    //check( memo.size() <= 256, "memo has more than 256 bytes" );
+
+    check( lock_act.quantity.quantity.is_valid(), "invalid quantity" );
+    check( lock_act.quantity.quantity.amount > 0, "must issue positive quantity" );
+
+    wraptoken::xfer x = {
+      .owner = _self, // todo - check whether this should show as lock_act.beneficiary
+      .quantity = extended_asset(lock_act.quantity.quantity, pair.token_contract),
+      .beneficiary = lock_act.owner
+    };
+
+    // return to lock_act.owner so can be withdrawn from wraplock
+    wraptoken::emitxfer_action act(_self, permission_level{_self, "active"_n});
+    act.send(x);
+
+    return { .receipt_digest = digest, .refund = x };
 
-    _issue(prover, actionproof);
 }
 
-// mints the wrapped token, requires light block proof and action proof
-void wraptoken::issueb(const name& prover, const bridge::lightproof blockproof, const bridge::actionproof actionproof)
+// the header of the proven block, where the action merkle root and the block timestamp come from
+template <typename Proof>
+static const bridge::blockheader& proven_header(const Proof& blockproof)
 {
+    if constexpr (std::is_same_v<Proof, bridge::heavyproof>) return blockproof.blocktoprove.block.header;
+    else return blockproof.header;
+}
+
+// issues or cancels the locks of every action proof, requires a block proof and action proofs from the same block. The proof
+// kind and the operation are resolved at compile time, so each instantiation only carries the code of its own proof kind.
+template <bool cancel, typename Proof>
+std::conditional_t<cancel, wraptoken::cancelresult, wraptoken::issueresult> wraptoken::_prove(const name& prover, const Proof& blockproof, const bridge::actionproof* actionproofs, size_t count,
+                                                                                               const std::optional<checksum256>& block_id)
+{
+    static_assert(std::is_same_v<Proof, bridge::heavyproof> || std::is_same_v<Proof, bridge::lightproof>, "unsupported block proof");
+
     require_auth(prover);
 
-    check(global_config.exists(), "contract must be initialized first");
-    auto global = global_config.get();
+    context ctx(*this);
+    check(ctx.initialized, "contract must be initialized first");
+    const auto& global = ctx.config;
 
     check(global.enabled == true, "contract has been disabled");
 
-    check(blockproof.chain_id == global.paired_chain_id, "proof chain does not match paired chain");
+    const bridge::blockheader& header = proven_header(blockproof);
+    const time_point_sec block_time(header.timestamp.to_time_point());
+
+    if constexpr (cancel) {
+        check(current_time_point().sec_since_epoch() > block_time.sec_since_epoch() + 900, "must wait 15 minutes to cancel");
+    }
+
+    check(count > 0, "must provide at least one action proof");
 
-    // check proof against bridge
+    // check block proof and first action proof against bridge, the proof travels in the inline action payload
     // will fail tx if prove is invalid
-    auto p = _light_proof.get_or_create(_self, _light_proof_obj);
-    p.lp = blockproof;
-    _light_proof.set(p, _self);
-    wraptoken::lightproof_action checkproof_act(global.bridge_contract, permission_level{_self, "active"_n});
-    checkproof_act.send(_self, actionproof);
+    if constexpr (std::is_same_v<Proof, bridge::heavyproof>) {
+        wraptoken::heavyproof_action checkproof_act(global.bridge_contract, permission_level{_self, "active"_n});
+        checkproof_act.send(blockproof, actionproofs[0]);
+    }
+    else {
+        wraptoken::lightproof_action checkproof_act(global.bridge_contract, permission_level{_self, "active"_n});
+        checkproof_act.send(blockproof, actionproofs[0]);
+    }
+    cache_block_root(ctx, blockproof.chain_id, blockheaders::memo(header, block_id), prover);
+
+    // remaining action proofs only need to be included in the block the bridge verifies
+    std::conditional_t<cancel, cancelresult, issueresult> result;
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) merkle::check_action_proof(header.action_mroot, actionproofs[i]);
+        if constexpr (cancel) result = _cancel(ctx, prover, blockproof.chain_id, actionproofs[i], block_time);
+        else result = _issue(ctx, prover, blockproof.chain_id, actionproofs[i], block_time);
+    }
 
-    _issue(prover, actionproof);
+    ctx.flush();
+
+    return result;
 }
 
-void wraptoken::_cancel(const name& prover, const bridge::actionproof actionproof)
+// mints the wrapped token, requires heavy block proof and action proof
+wraptoken::issueresult wraptoken::issuea(const name& prover, const bridge::heavyproof& blockproof, const bridge::actionproof& actionproof)
 {
-    auto global = global_config.get();
-
-    wraptoken::xfer lock_act = unpack<wraptoken::xfer>(actionproof.action.data);
-
-    check(actionproof.action.account == global.paired_wraplock_contract, "proof account does not match paired wraplock account");
+    return _prove<false>(prover, blockproof, &actionproof, 1);
+}
 
-    add_or_assert(actionproof, prover);
+// mints the wrapped token, requires light block proof and action proof
+wraptoken::issueresult wraptoken::issueb(const name& prover, const bridge::lightproof& blockproof, const bridge::actionproof& actionproof)
+{
+    return _prove<false>(prover, blockproof, &actionproof, 1);
+}
 
-    auto sym = lock_act.quantity.quantity.symbol;
-    check( sym.is_valid(), "invalid symbol name" );
-    //check( memo.size() <= 256, "memo has more than 256 bytes" );
+wraptoken::cancelresult wraptoken::cancela(const name& prover, const bridge::heavyproof& blockproof, const bridge::actionproof& actionproof)
+{
+    return _prove<true>(prover, blockproof, &actionproof, 1);
+}
 
-    check(actionproof.action.name == "emitxfer"_n, "must provide proof of token locking before issuing");
+wraptoken::cancelresult wraptoken::cancelb(const name& prover, const bridge::lightproof& blockproof, const bridge::actionproof& actionproof)
+{
+    return _prove<true>(prover, blockproof, &actionproof, 1);
+}
 
-    check( lock_act.quantity.quantity.is_valid(), "invalid quantity" );
-    check( lock_act.quantity.quantity.amount > 0, "must issue positive quantity" );
+// mints the wrapped tokens for every action proof, requires heavy block proof and action proofs from the same block
+void wraptoken::issuebatcha(const name& prover, const bridge::heavyproof& blockproof, const std::vector<bridge::actionproof>& actionproofs)
+{
+    _prove<false>(prover, blockproof, actionproofs.data(), actionproofs.size());
+}
 
-    wraptoken::xfer x = {
-      .owner = _self, // todo - check whether this should show as lock_act.beneficiary
-      .quantity = extended_asset(lock_act.quantity.quantity, global.paired_token_contract),
-      .beneficiary = lock_act.owner
-    };
+// mints the wrapped tokens for every action proof, requires light block proof and action proofs from the same block
+void wraptoken::issuebatchb(const name& prover, const bridge::lightproof& blockproof, const std::vector<bridge::actionproof>& actionproofs)
+{
+    _prove<false>(prover, blockproof, actionproofs.data(), actionproofs.size());
+}
 
-    // return to lock_act.owner so can be withdrawn from wraplock
-    wraptoken::emitxfer_action act(_self, permission_level{_self, "active"_n});
-    act.send(x);
+void wraptoken::cancelbatcha(const name& prover, const bridge::heavyproof& blockproof, const std::vector<bridge::actionproof>& actionproofs)
+{
+    _prove<true>(prover, blockproof, actionproofs.data(), actionproofs.size());
+}
 
+void wraptoken::cancelbatchb(const name& prover, const bridge::lightproof& blockproof, const std::vector<bridge::actionproof>& actionproofs)
+{
+    _prove<true>(prover, blockproof, actionproofs.data(), actionproofs.size());
 }
 
-void wraptoken::cancela(const name& prover, const bridge::heavyproof blockproof, const bridge::actionproof actionproof)
+// mints the wrapped token against a block root cached by an earlier proof action
+wraptoken::issueresult wraptoken::issuec(const name& prover, const checksum256& chain_id, const checksum256& block_id, const bridge::actionproof& actionproof)
 {
     require_auth(prover);
 
-    check(global_config.exists(), "contract must be initialized first");
-    auto global = global_config.get();
+    context ctx(*this);
+    check(ctx.initialized, "contract must be initialized first");
 
-    check(global.enabled == true, "contract has been disabled");
+    check(ctx.config.enabled == true, "contract has been disabled");
 
-    check(blockproof.chain_id == global.paired_chain_id, "proof chain does not match paired chain");
+    const auto& root = cached_block_root(chain_id, block_id);
+    merkle::check_action_proof(root.action_mroot, actionproof);
 
-    check(current_time_point().sec_since_epoch() > blockproof.blocktoprove.block.header.timestamp.to_time_point().sec_since_epoch() + 900, "must wait 15 minutes to cancel");
+    const auto result = _issue(ctx, prover, chain_id, actionproof, root.block_time);
 
-    // check proof against bridge
-    // will fail tx if prove is invalid
-    auto p = _heavy_proof.get_or_create(_self, _heavy_proof_obj);
-    p.hp = blockproof;
-    _heavy_proof.set(p, _self);
-    wraptoken::heavyproof_action checkproof_act(global.bridge_contract, permission_level{_self, "active"_n});
-    checkproof_act.send(_self, actionproof);
+    ctx.flush();
 
-    _cancel(prover, actionproof);
+    return result;
 }
 
-void wraptoken::cancelb(const name& prover, const bridge::lightproof blockproof, const bridge::actionproof actionproof)
+// cancels a lock against a block root cached by an earlier proof action
+wraptoken::cancelresult wraptoken::cancelc(const name& prover, const checksum256& chain_id, const checksum256& block_id, const bridge::actionproof& actionproof)
 {
     require_auth(prover);
 
-    check(global_config.exists(), "contract must be initialized first");
-    auto global = global_config.get();
+    context ctx(*this);
+    check(ctx.initialized, "contract must be initialized first");
 
-    check(global.enabled == true, "contract has been disabled");
+    check(ctx.config.enabled == true, "contract has been disabled");
 
-    check(blockproof.chain_id == global.paired_chain_id, "proof chain does not match paired chain");
+    const auto& root = cached_block_root(chain_id, block_id);
+    check(current_time_point().sec_since_epoch() > root.block_time.sec_since_epoch() + 900, "must wait 15 minutes to cancel");
 
-    check(current_time_point().sec_since_epoch() > blockproof.header.timestamp.to_time_point().sec_since_epoch() + 900, "must wait 15 minutes to cancel");
+    merkle::check_action_proof(root.action_mroot, actionproof);
 
-    // check proof against bridge
-    // will fail tx if prove is invalid
-    auto p = _light_proof.get_or_create(_self, _light_proof_obj);
-    p.lp = blockproof;
-    _light_proof.set(p, _self);
-    wraptoken::lightproof_action checkproof_act(global.bridge_contract, permission_level{_self, "active"_n});
-    checkproof_act.send(_self, actionproof);
+    const auto result = _cancel(ctx, prover, chain_id, actionproof, root.block_time);
 
-    _cancel(prover, actionproof);
+    ctx.flush();
+
+    return result;
+}
+
+// mints the wrapped token, requires compact heavy block proof and action proof
+wraptoken::issueresult wraptoken::issued(const name& prover, const compactproof::compactheavyproof& blockproof, const bridge::actionproof& actionproof)
+{
+    // the proven block id derived while expanding is reused for the block root cache
+    std::optional<checksum256> block_id;
+    const bridge::heavyproof expanded = compactproof::expand(blockproof, &block_id);
+    return _prove<false>(prover, expanded, &actionproof, 1, block_id);
+}
+
+// cancels a lock, requires compact heavy block proof and action proof
+wraptoken::cancelresult wraptoken::canceld(const name& prover, const compactproof::compactheavyproof& blockproof, const bridge::actionproof& actionproof)
+{
+    std::optional<checksum256> block_id;
+    const bridge::heavyproof expanded = compactproof::expand(blockproof, &block_id);
+    return _prove<true>(prover, expanded, &actionproof, 1, block_id);
 }
 
 //emits an xfer receipt to serve as proof in interchain transfers
@@ -231,6 +538,353 @@ void wraptoken::emitxfer(const wraptoken::xfer& xfer){
 
 }
 
+void wraptoken::emitroot(const uint64_t epoch, const uint64_t first_id, const uint64_t count, const checksum256& root){
+
+    check(global_config.exists(), "contract must be initialized first");
+
+    require_auth(_self);
+
+}
+
+//Choose between sending an emitxfer per retirement and committing to queued retirements with an emitroot.
+void wraptoken::setoutbox(const bool enabled, const uint32_t commit_interval){
+
+    check(global_config.exists(), "contract must be initialized first");
+
+    require_auth(_self);
+
+    auto params = settings_config.get_or_default(settings{});
+    params.outbox = enabled;
+    params.commit_interval = commit_interval;
+    settings_config.set(params, _self);
+
+}
+
+//Serve an additional native chain, wraplock contract and token contract.
+void wraptoken::addpair(const checksum256& chain_id, const name& wraplock_contract, const name& token_contract){
+
+    check(global_config.exists(), "contract must be initialized first");
+
+    require_auth(_self);
+
+    const auto global = global_config.get();
+    check(pair_key(chain_id, wraplock_contract, token_contract) != pair_key(global.paired_chain_id, global.paired_wraplock_contract, global.paired_token_contract), "pair is already served");
+
+    auto pairs_by_key = _pairstable.get_index<"pairkey"_n>();
+    check(pairs_by_key.find(pair_key(chain_id, wraplock_contract, token_contract)) == pairs_by_key.end(), "pair is already served");
+
+    _pairstable.emplace( _self, [&]( auto& p ){
+        p.id = std::max<uint64_t>(1, _pairstable.available_primary_key());
+        p.chain_id = chain_id;
+        p.wraplock_contract = wraplock_contract;
+        p.token_contract = token_contract;
+    });
+
+}
+
+//Route a wrapped symbol to one of the pairs, or back to the pair set by init.
+void wraptoken::setroute(const symbol_code& sym, const uint64_t pair_id){
+
+    check(global_config.exists(), "contract must be initialized first");
+
+    require_auth(_self);
+
+    check( sym.is_valid(), "invalid symbol name" );
+
+    set_route(sym, pair_id);
+
+}
+
+//routes a symbol to a pair (throws an exception if the symbol has outstanding supply)
+void wraptoken::set_route(const symbol_code& sym, const uint64_t pair_id){
+
+    check( pair_id == 0 || _pairstable.find(pair_id) != _pairstable.end(), "pair does not exist" );
+
+    stats statstable( _self, sym.raw() );
+    auto st = statstable.find( sym.raw() );
+    check( st == statstable.end() || st->supply.amount == 0, "cannot reroute a symbol with outstanding supply" );
+
+    auto r = _routestable.find(sym.raw());
+    if (pair_id == 0) {
+        check( r != _routestable.end(), "symbol is not routed" );
+        _routestable.erase(r);
+    }
+    else if (r == _routestable.end()) {
+        _routestable.emplace( _self, [&]( auto& row ){
+            row.sym = sym;
+            row.pair_id = pair_id;
+        });
+    }
+    else {
+        _routestable.modify( r, same_payer, [&]( auto& row ){
+            row.pair_id = pair_id;
+        });
+    }
+
+}
+
+void wraptoken::regsymbol(const asset& max_supply, const uint64_t pair_id){
+
+    check(global_config.exists(), "contract must be initialized first");
+
+    require_auth(_self);
+
+    auto sym = max_supply.symbol;
+    check( sym.is_valid(), "invalid symbol name" );
+    check( max_supply.is_valid(), "invalid supply");
+    check( max_supply.amount > 0, "max-supply must be positive");
+
+    stats statstable( _self, sym.code().raw() );
+    auto st = statstable.find( sym.code().raw() );
+    if (st == statstable.end()) {
+        statstable.emplace( _self, [&]( auto& s ) {
+           s.supply.symbol = sym;
+           s.max_supply    = max_supply;
+           s.issuer        = _self;
+        });
+    }
+    else {
+        check( st->supply.symbol == sym, "symbol precision mismatch" );
+        check( max_supply.amount >= st->supply.amount, "max-supply is below the outstanding supply" );
+        statstable.modify( st, same_payer, [&]( auto& s ) {
+           s.max_supply = max_supply;
+        });
+    }
+
+    auto r = _routestable.find(sym.code().raw());
+    const uint64_t current = r == _routestable.end() ? 0 : r->pair_id;
+    if (pair_id != current) set_route(sym.code(), pair_id);
+
+}
+
+std::vector<wraptoken::balanceresult> wraptoken::getbalances(const std::vector<balancequery>& queries){
+
+    std::vector<balanceresult> results;
+    results.reserve(queries.size());
+
+    for (const balancequery& q : queries) {
+        balanceresult r{ .owner = q.owner, .sym = q.sym, .exists = false };
+
+        accounts acnts( _self, q.owner.value );
+        auto itr = acnts.find( q.sym.raw() );
+        if (itr != acnts.end()) {
+            r.exists = true;
+            r.balance = itr->balance;
+        }
+
+        results.push_back(r);
+    }
+
+    return results;
+
+}
+
+std::vector<wraptoken::supplyresult> wraptoken::getsupplies(const std::vector<symbol_code>& syms){
+
+    std::vector<supplyresult> results;
+    results.reserve(syms.size());
+
+    for (const symbol_code& sym : syms) {
+        supplyresult r{ .sym = sym, .exists = false };
+
+        stats statstable( _self, sym.raw() );
+        auto itr = statstable.find( sym.raw() );
+        if (itr != statstable.end()) {
+            r.exists = true;
+            r.supply = itr->supply;
+            r.max_supply = itr->max_supply;
+        }
+
+        results.push_back(r);
+    }
+
+    return results;
+
+}
+
+std::vector<wraptoken::receiptstatus> wraptoken::getreceipts(const std::vector<checksum256>& digests){
+
+    std::vector<receiptstatus> results;
+    results.reserve(digests.size());
+
+    auto legacy_index = _processedtable.get_index<"digest"_n>();
+
+    for (const checksum256& digest : digests) {
+        receiptstatus r{ .digest = digest, .processed = false, .legacy = false };
+
+        if (const receipt* row = find_receipt(digest)) {
+            r.processed = true;
+            r.block_time = row->block_time;
+        }
+        else if (legacy_index.find(digest) != legacy_index.end()) {
+            r.processed = true;
+            r.legacy = true;
+        }
+
+        results.push_back(r);
+    }
+
+    return results;
+
+}
+
+wraptoken::verdict wraptoken::validate(const bool cancel, const checksum256& chain_id, const time_point_sec& block_time, const bridge::actionproof& actionproof){
+
+    std::vector<char> serializedReceipt = pack(actionproof.receipt);
+    const checksum256 digest = sha256(serializedReceipt.data(), serializedReceipt.size());
+
+    auto result = [&](uint8_t code, const char* reason) {
+        return verdict{ .code = code, .reason = reason, .receipt_digest = digest };
+    };
+
+    context ctx(*this);
+    if (!ctx.initialized) return result(VERDICT_NOT_INITIALIZED, "contract must be initialized first");
+    if (!ctx.config.enabled) return result(VERDICT_DISABLED, "contract has been disabled");
+
+    uint32_t now = current_time_point().sec_since_epoch();
+    if (cancel && now <= block_time.sec_since_epoch() + 900) return result(VERDICT_CANCEL_TOO_EARLY, "must wait 15 minutes to cancel");
+
+    if (actionproof.action.name != "emitxfer"_n) return result(VERDICT_WRONG_ACTION, "must provide proof of token locking before issuing");
+    if (!is_xfer_payload(actionproof)) return result(VERDICT_MALFORMED_XFER, "emitxfer payload is malformed");
+
+    const wraptoken::xfer lock_act = read_xfer(actionproof);
+
+    auto sym = lock_act.quantity.quantity.symbol;
+    if (!sym.is_valid()) return result(VERDICT_INVALID_SYMBOL, "invalid symbol name");
+
+    const auto& st = ctx.stats_for( sym.code() );
+    if (!cancel && !st.exists) return result(VERDICT_NOT_REGISTERED, "symbol is not registered");
+
+    const auto& pair = ctx.pair_for( sym.code() );
+    if (chain_id != pair.chain_id) return result(VERDICT_WRONG_CHAIN, "proof chain does not match paired chain");
+    if (actionproof.action.account != pair.wraplock_contract) return result(VERDICT_WRONG_ACCOUNT, "proof account does not match paired wraplock account");
+    if (lock_act.quantity.contract != pair.token_contract) return result(VERDICT_WRONG_CONTRACT, "locked token contract does not match paired token contract");
+
+    // same replay protection checks as add_or_assert
+    const settings& replay = ctx.params();
+    if (replay.replay_window > 0 && uint64_t(block_time.sec_since_epoch()) + replay.replay_window < now) return result(VERDICT_OUTSIDE_WINDOW, "proof is older than the replay protection window");
+    if (block_time <= replay.pruned_until) return result(VERDICT_PRUNED, "proof is older than the pruned replay protection records");
+
+    if (replay.legacy_time == time_point_sec() || block_time < replay.legacy_time) {
+        auto legacy_index = _processedtable.get_index<"digest"_n>();
+        if (legacy_index.find(digest) != legacy_index.end()) return result(VERDICT_ALREADY_PROVED, "action already proved");
+    }
+    if (find_receipt(digest) != nullptr) return result(VERDICT_ALREADY_PROVED, "action already proved");
+
+    if (!lock_act.quantity.quantity.is_valid()) return result(VERDICT_INVALID_QUANTITY, "invalid quantity");
+    if (lock_act.quantity.quantity.amount <= 0) return result(VERDICT_INVALID_QUANTITY, "must issue positive quantity");
+
+    if (!cancel) {
+        if (lock_act.quantity.quantity.symbol != st.row.supply.symbol) return result(VERDICT_PRECISION, "symbol precision mismatch");
+        if (lock_act.quantity.quantity.amount > st.row.max_supply.amount - st.row.supply.amount) return result(VERDICT_SUPPLY_EXCEEDED, "quantity exceeds available supply");
+
+        // rejected by direct mode and by the inline transfer alike, such locks can only be cancelled
+        if (!is_account(lock_act.beneficiary)) return result(VERDICT_NO_BENEFICIARY, "to account does not exist");
+    }
+
+    return result(VERDICT_OK, "");
+
+}
+
+//Enable or disable caching of verified block roots.
+void wraptoken::setrootcache(const uint32_t ttl){
+
+    check(global_config.exists(), "contract must be initialized first");
+
+    require_auth(_self);
+
+    auto params = settings_config.get_or_default(settings{});
+    params.root_cache_ttl = ttl;
+    settings_config.set(params, _self);
+
+}
+
+//Choose between direct crediting and the inline transfer for issued tokens.
+void wraptoken::setissuemode(const bool direct){
+
+    check(global_config.exists(), "contract must be initialized first");
+
+    require_auth(_self);
+
+    auto params = settings_config.get_or_default(settings{});
+    check(params.direct_issue != direct, "issue mode is already set");
+    params.direct_issue = direct;
+    settings_config.set(params, _self);
+
+}
+
+//Remove proofs left behind in the singletons by earlier versions of the contract, refunding their ram.
+void wraptoken::clearproofs(){
+
+    require_auth(_self);
+
+    lptable light_proof(_self, _self.value);
+    hptable heavy_proof(_self, _self.value);
+
+    check(light_proof.exists() || heavy_proof.exists(), "no stored proofs to clear");
+
+    if (light_proof.exists()) light_proof.remove();
+    if (heavy_proof.exists()) heavy_proof.remove();
+
+}
+
+//Configure the replay protection window and the amount of pruning done by each proof.
+void wraptoken::setreplay(const uint32_t replay_window, const uint32_t prune_count){
+
+    check(global_config.exists(), "contract must be initialized first");
+
+    require_auth(_self);
+
+    check(replay_window == 0 || replay_window > 900, "replay window must exceed the cancel delay");
+
+    auto replay = settings_config.get_or_default(settings{});
+    replay.replay_window = replay_window;
+    replay.prune_count = prune_count;
+
+    // rows in the legacy table were all added before the first configuration
+    if (replay.legacy_time == time_point_sec()) replay.legacy_time = time_point_sec(current_time_point());
+
+    settings_config.set(replay, _self);
+
+}
+
+//Move receipt digests from the legacy processed table into the receipts table.
+void wraptoken::migrate(const uint32_t max_rows){
+
+    require_auth(_self);
+
+    check(max_rows > 0, "must migrate at least one row");
+    check(_processedtable.begin() != _processedtable.end(), "nothing left to migrate");
+
+    auto replay = settings_config.get_or_default(settings{});
+
+    // legacy rows carry no block time, record them at the latest time they can prove
+    if (replay.legacy_time == time_point_sec()) {
+        replay.legacy_time = time_point_sec(current_time_point());
+        settings_config.set(replay, _self);
+    }
+
+    uint32_t count = max_rows;
+    auto itr = _processedtable.begin();
+    while (count > 0 && itr != _processedtable.end()) {
+        add_receipt(itr->receipt_digest, replay.legacy_time, _self);
+        itr = _processedtable.erase(itr);
+        count--;
+    }
+
+}
+
+//Erase expired receipt digests, callable by anyone.
+void wraptoken::prune(const uint32_t max_rows){
+
+    check(max_rows > 0, "must prune at least one row");
+
+    context ctx(*this);
+    prune_receipts(ctx, max_rows);
+    ctx.flush();
+
+}
+
 //Disable all user actions on the contract.
 void wraptoken::disable(){
 
@@ -257,144 +911,300 @@ void wraptoken::enable(){
 
 }
 
-void wraptoken::retire(const name& owner,  const asset& quantity, const name& beneficiary)
+// sends the xfer for a retirement, or queues it for the next outbox commitment when the outbox is enabled
+std::optional<uint64_t> wraptoken::emit_retirement(context& ctx, const name& owner, const asset& quantity, const name& beneficiary)
 {
-    check(global_config.exists(), "contract must be initialized first");
+    wraptoken::xfer x = {
+      .owner = owner,
+      .quantity = extended_asset(quantity, ctx.pair_for(quantity.symbol.code()).token_contract),
+      .beneficiary = beneficiary
+    };
+
+    auto& params = ctx.params();
+
+    if (params.outbox) {
+        const uint64_t id = params.outbox_next_id;
+        _outboxtable.emplace( owner, [&]( auto& e ){
+            e.id = id;
+            e.transfer = x;
+        });
+        params.outbox_next_id++;
+        ctx.set_params_dirty();
+        return id;
+    }
+
+    wraptoken::emitxfer_action act(_self, permission_level{_self, "active"_n});
+    act.send(x);
+    return std::nullopt;
+}
+
+void wraptoken::commit(const uint32_t max_rows)
+{
+    context ctx(*this);
+    check(ctx.initialized, "contract must be initialized first");
+
+    check(ctx.config.enabled == true, "contract has been disabled");
+
+    check(max_rows > 0, "must commit at least one retirement");
+
+    auto& params = ctx.params();
+    check(time_point_sec(current_time_point()) >= params.last_commit + params.commit_interval, "outbox epoch is not over yet");
+
+    auto itr = _outboxtable.begin();
+    check(itr != _outboxtable.end(), "outbox is empty");
+
+    // ids are assigned in order and rows are erased in order, so the committed ids are contiguous
+    const uint64_t first_id = itr->id;
+    std::vector<checksum256> leaves;
+
+    while (itr != _outboxtable.end() && leaves.size() < max_rows) {
+        std::vector<char> serialized = pack(std::make_tuple(itr->id, itr->transfer));
+        leaves.push_back(sha256(serialized.data(), serialized.size()));
+        itr = _outboxtable.erase(itr);
+    }
+
+    wraptoken::emitroot_action act(_self, permission_level{_self, "active"_n});
+    act.send(params.epoch, first_id, uint64_t(leaves.size()), merkle::tree_root(leaves));
+
+    params.epoch++;
+    params.last_commit = time_point_sec(current_time_point());
+    ctx.set_params_dirty();
+
+    ctx.flush();
+}
+
+wraptoken::retireresult wraptoken::retire(const name& owner,  const asset& quantity, const name& beneficiary)
+{
+    context ctx(*this);
+    check(ctx.initialized, "contract must be initialized first");
 
     require_auth( owner );
 
-    auto global = global_config.get();
+    const auto& global = ctx.config;
 
     check(global.enabled == true, "contract has been disabled");
 
     auto sym = quantity.symbol;
     check( sym.is_valid(), "invalid symbol name" );
 
-    stats statstable( get_self(), sym.code().raw() );
-    auto existing = statstable.find( sym.code().raw() );
-    check( existing != statstable.end(), "token with symbol does not exist" );
-    const auto& st = *existing;
+    auto& st = ctx.stats_for( sym.code() );
+    check( st.exists, "token with symbol does not exist" );
 
     check( quantity.is_valid(), "invalid quantity" );
     check( quantity.amount > 0, "must retire positive quantity" );
 
-    check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
+    check( quantity.symbol == st.row.supply.symbol, "symbol precision mismatch" );
 
-    statstable.modify( st, same_payer, [&]( auto& s ) {
-       s.supply -= quantity;
-    });
+    st.row.supply -= quantity;
+    st.dirty = true;
 
-    sub_balance( owner, quantity );
+    sub_balance( ctx, owner, quantity );
 
-    wraptoken::xfer x = {
-      .owner = owner,
-      .quantity = extended_asset(quantity, global.paired_token_contract),
-      .beneficiary = beneficiary
+    const auto outbox_id = emit_retirement( ctx, owner, quantity, beneficiary );
+
+    retireresult result = {
+      .supply = st.row.supply,
+      .balance = ctx.balance_for( owner, sym.code() ).row.balance,
+      .outbox_id = outbox_id
     };
 
-    wraptoken::emitxfer_action act(_self, permission_level{_self, "active"_n});
-    act.send(x);
+    ctx.flush();
+
+    return result;
 
 }
 
-void wraptoken::transfer( const name&    from,
-                      const name&    to,
-                      const asset&   quantity,
-                      const string&  memo )
+void wraptoken::retirebatch(const name& owner, const std::vector<retirement>& retirements)
 {
-    check(global_config.exists(), "contract must be initialized first");
+    context ctx(*this);
+    check(ctx.initialized, "contract must be initialized first");
+
+    require_auth( owner );
+
+    const auto& global = ctx.config;
 
-    auto global = global_config.get();
     check(global.enabled == true, "contract has been disabled");
 
+    check( retirements.size() > 0, "must provide at least one retirement" );
+
+    // totals debited from the owner, one entry per symbol
+    std::map<uint64_t, asset> totals;
+
+    for (const retirement& r : retirements) {
+        auto sym = r.quantity.symbol;
+        check( sym.is_valid(), "invalid symbol name" );
+
+        auto& st = ctx.stats_for( sym.code() );
+        check( st.exists, "token with symbol does not exist" );
+
+        check( r.quantity.is_valid(), "invalid quantity" );
+        check( r.quantity.amount > 0, "must retire positive quantity" );
+
+        check( r.quantity.symbol == st.row.supply.symbol, "symbol precision mismatch" );
+
+        st.row.supply -= r.quantity;
+        st.dirty = true;
+
+        auto [total, inserted] = totals.try_emplace( sym.code().raw(), r.quantity );
+        if (!inserted) total->second += r.quantity;
+
+        emit_retirement( ctx, owner, r.quantity, r.beneficiary );
+    }
+
+    for (const auto& total : totals) sub_balance( ctx, owner, total.second );
+
+    ctx.flush();
+
+}
+
+wraptoken::transferresult wraptoken::transfer( const name&    from,
+                                              const name&    to,
+                                              const asset&   quantity,
+                                              const string&  memo )
+{
+    context ctx(*this);
+    check(ctx.initialized, "contract must be initialized first");
+
+    check(ctx.config.enabled == true, "contract has been disabled");
+
     check( from != to, "cannot transfer to self" );
     require_auth( from );
     check( is_account( to ), "to account does not exist");
     auto sym = quantity.symbol.code();
-    stats statstable( get_self(), sym.raw() );
-    const auto& st = statstable.get( sym.raw() );
+    const auto& st = ctx.stats_for( sym );
+    check( st.exists, "unable to find key" );
 
     require_recipient( from );
     require_recipient( to );
 
     check( quantity.is_valid(), "invalid quantity" );
     check( quantity.amount > 0, "must transfer positive quantity" );
-    check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
+    check( quantity.symbol == st.row.supply.symbol, "symbol precision mismatch" );
     check( memo.size() <= 256, "memo has more than 256 bytes" );
 
     auto payer = has_auth( to ) ? to : from;
 
-    sub_balance( from, quantity );
-    add_balance( to, quantity, payer );
+    sub_balance( ctx, from, quantity );
+    add_balance( ctx, to, quantity, payer );
+
+    transferresult result = {
+      .from_balance = ctx.balance_for( from, sym ).row.balance,
+      .to_balance = ctx.balance_for( to, sym ).row.balance
+    };
+
+    ctx.flush();
+
+    return result;
 }
 
-void wraptoken::sub_balance( const name& owner, const asset& value ){
+void wraptoken::transfermany( const name&                   from,
+                              const std::vector<payout>&    payouts,
+                              const string&                 memo )
+{
+    context ctx(*this);
+    check(ctx.initialized, "contract must be initialized first");
+
+    check(ctx.config.enabled == true, "contract has been disabled");
+
+    require_auth( from );
+    check( payouts.size() > 0, "must provide at least one payout" );
+    check( memo.size() <= 256, "memo has more than 256 bytes" );
+
+    require_recipient( from );
+
+    // totals debited from the sender, one entry per symbol
+    std::map<uint64_t, asset> totals;
 
-   accounts from_acnts( get_self(), owner.value );
+    for (const payout& p : payouts) {
+       check( from != p.to, "cannot transfer to self" );
+       check( is_account( p.to ), "to account does not exist");
 
-   const auto& from = from_acnts.get( value.symbol.code().raw(), "no balance object found" );
-   check( from.balance.amount >= value.amount, "overdrawn balance" );
+       const auto& st = ctx.stats_for( p.quantity.symbol.code() );
+       check( st.exists, "unable to find key" );
 
-   from_acnts.modify( from, owner, [&]( auto& a ) {
-         a.balance -= value;
-      });
+       check( p.quantity.is_valid(), "invalid quantity" );
+       check( p.quantity.amount > 0, "must transfer positive quantity" );
+       check( p.quantity.symbol == st.row.supply.symbol, "symbol precision mismatch" );
+
+       require_recipient( p.to );
+
+       auto [total, inserted] = totals.try_emplace( p.quantity.symbol.code().raw(), p.quantity );
+       if (!inserted) total->second += p.quantity;
+
+       add_balance( ctx, p.to, p.quantity, has_auth( p.to ) ? p.to : from );
+    }
+
+    for (const auto& total : totals) sub_balance( ctx, from, total.second );
+
+    ctx.flush();
 }
 
-void wraptoken::add_balance( const name& owner, const asset& value, const name& ram_payer ){
+void wraptoken::sub_balance( context& ctx, const name& owner, const asset& value ){
+
+   auto& from = ctx.balance_for( owner, value.symbol.code() );
 
-   accounts to_acnts( get_self(), owner.value );
-   auto to = to_acnts.find( value.symbol.code().raw() );
-   if( to == to_acnts.end() ) {
-      to_acnts.emplace( ram_payer, [&]( auto& a ){
-        a.balance = value;
-      });
+   check( from.exists, "no balance object found" );
+   check( from.row.balance.amount >= value.amount, "overdrawn balance" );
+
+   from.row.balance -= value;
+   if( from.stored ) from.ram_payer = owner;
+   from.dirty = true;
+}
+
+void wraptoken::add_balance( context& ctx, const name& owner, const asset& value, const name& ram_payer ){
+
+   auto& to = ctx.balance_for( owner, value.symbol.code() );
+   if( !to.exists ) {
+      to.row.balance = value;
+      to.exists = true;
+      to.ram_payer = ram_payer;
    } else {
-      to_acnts.modify( to, same_payer, [&]( auto& a ) {
-        a.balance += value;
-      });
+      to.row.balance += value;
    }
+   to.dirty = true;
 
 }
 
 void wraptoken::open( const name& owner, const symbol& symbol, const name& ram_payer )
 {
-   check(global_config.exists(), "contract must be initialized first");
+   context ctx(*this);
+   check(ctx.initialized, "contract must be initialized first");
 
-   auto global = global_config.get();
-   check(global.enabled == true, "contract has been disabled");
+   check(ctx.config.enabled == true, "contract has been disabled");
 
    require_auth( ram_payer );
 
    check( is_account( owner ), "owner account does not exist" );
 
-   auto sym_code_raw = symbol.code().raw();
-   stats statstable( get_self(), sym_code_raw );
-   const auto& st = statstable.get( sym_code_raw, "symbol does not exist" );
-   check( st.supply.symbol == symbol, "symbol precision mismatch" );
-
-   accounts acnts( get_self(), owner.value );
-   auto it = acnts.find( sym_code_raw );
-   if( it == acnts.end() ) {
-      acnts.emplace( ram_payer, [&]( auto& a ){
-        a.balance = asset{0, symbol};
-      });
+   const auto& st = ctx.stats_for( symbol.code() );
+   check( st.exists, "symbol does not exist" );
+   check( st.row.supply.symbol == symbol, "symbol precision mismatch" );
+
+   auto& it = ctx.balance_for( owner, symbol.code() );
+   if( !it.exists ) {
+      it.row.balance = asset{0, symbol};
+      it.exists = true;
+      it.ram_payer = ram_payer;
+      it.dirty = true;
    }
 
+   ctx.flush();
+
 }
 
 void wraptoken::close( const name& owner, const symbol& symbol )
 {
-   check(global_config.exists(), "contract must be initialized first");
+   context ctx(*this);
+   check(ctx.initialized, "contract must be initialized first");
 
-   auto global = global_config.get();
-   check(global.enabled == true, "contract has been disabled");
+   check(ctx.config.enabled == true, "contract has been disabled");
     
    require_auth( owner );
-   accounts acnts( get_self(), owner.value );
-   auto it = acnts.find( symbol.code().raw() );
-   check( it != acnts.end(), "Balance row already deleted or never existed. Action won't have any effect." );
-   check( it->balance.amount == 0, "Cannot close because the balance is not zero." );
-   acnts.erase( it );
+   auto& it = ctx.balance_for( owner, symbol.code() );
+   check( it.exists, "Balance row already deleted or never existed. Action won't have any effect." );
+   check( it.row.balance.amount == 0, "Cannot close because the balance is not zero." );
+   it.table.erase( it.table.find( symbol.code().raw() ) );
+   it.exists = it.stored = it.dirty = false;
 
 }
 
@@ -435,8 +1245,6 @@ void wraptoken::close( const name& owner, const symbol& symbol )
     _processedtable.erase(itr);
   }
 
-  if (_light_proof.exists()) _light_proof.remove();
-  if (_heavy_proof.exists()) _heavy_proof.remove();
 
 }*/
 
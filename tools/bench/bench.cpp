@@ -0,0 +1,109 @@
+#include <bench.hpp>
+#include <runtime.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace bench {
+
+   allocation_counters& allocations() {
+      static allocation_counters counters;
+      return counters;
+   }
+
+   void suite::add(const std::string& name, std::function<void()> fn) {
+      _entries.push_back(entry{ name, std::move(fn) });
+   }
+
+   std::vector<result> suite::run(const std::string& filter, uint64_t min_time_ms) const {
+      using clock = std::chrono::steady_clock;
+      std::vector<result> results;
+
+      for (const entry& e : _entries) {
+         if (!filter.empty() && e.name.find(filter) == std::string::npos) continue;
+
+         // warm up, then double the batch until it runs for at least min_time_ms
+         e.fn();
+         uint64_t iterations = 1;
+         for (;;) {
+            allocation_counters before = allocations();
+            auto start = clock::now();
+            for (uint64_t i = 0; i < iterations; i++) e.fn();
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+            allocation_counters after = allocations();
+
+            if (uint64_t(elapsed) >= min_time_ms * 1000000 || iterations >= (1ULL << 32)) {
+               results.push_back(result{
+                  e.name,
+                  iterations,
+                  double(elapsed) / iterations,
+                  double(after.count - before.count) / iterations,
+                  double(after.bytes - before.bytes) / iterations
+               });
+               break;
+            }
+            iterations *= 2;
+         }
+      }
+
+      return results;
+   }
+
+}
+
+void* operator new(size_t size) {
+   bench::allocations().count++;
+   bench::allocations().bytes += size;
+   if (void* p = malloc(size ? size : 1)) return p;
+   abort();
+}
+
+void* operator new[](size_t size) {
+   return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+   free(p);
+}
+
+void operator delete[](void* p) noexcept {
+   free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+   free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+   free(p);
+}
+
+int main(int argc, char** argv) {
+   std::string filter;
+   uint64_t min_time_ms = 200;
+
+   for (int i = 1; i < argc; i++) {
+      if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+      else if (!strcmp(argv[i], "--min-time") && i + 1 < argc) min_time_ms = strtoull(argv[++i], nullptr, 10);
+      else {
+         printf("usage: %s [--filter <substring>] [--min-time <ms>]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   runtime::install_crypto();
+
+   bench::suite s;
+   bench::register_primitives(s);
+   bench::register_proofs(s);
+
+   printf("%-40s %12s %12s %12s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op", "bytes/op");
+   for (const bench::result& r : s.run(filter, min_time_ms)) {
+      printf("%-40s %12llu %12.1f %12.2f %12.1f\n", r.name.c_str(), (unsigned long long)r.iterations, r.ns_per_op, r.allocs_per_op, r.bytes_per_op);
+   }
+
+   return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+   // heap activity recorded by the replaced global operator new
+   struct allocation_counters {
+      uint64_t count = 0;
+      uint64_t bytes = 0;
+   };
+
+   allocation_counters& allocations();
+
+   // prevents the optimizer from discarding a computed value
+   template <typename T>
+   inline void keep(const T& value) {
+      asm volatile("" : : "r"(&value) : "memory");
+   }
+
+   struct result {
+      std::string   name;
+      uint64_t      iterations;
+      double        ns_per_op;
+      double        allocs_per_op;
+      double        bytes_per_op;
+   };
+
+   class suite {
+      public:
+         // registers a benchmark, `fn` runs one operation
+         void add(const std::string& name, std::function<void()> fn);
+
+         std::vector<result> run(const std::string& filter, uint64_t min_time_ms) const;
+
+      private:
+         struct entry {
+            std::string             name;
+            std::function<void()>   fn;
+         };
+
+         std::vector<entry> _entries;
+   };
+
+   void register_primitives(suite& s);
+   void register_proofs(suite& s);
+
+}
@@ -0,0 +1,118 @@
+#include <bench.hpp>
+#include <blockheaders.hpp>
+#include <fixtures.hpp>
+
+// serialization and hashing primitives on the issue/cancel hot path
+namespace bench {
+
+   using namespace eosio;
+
+   void register_primitives(suite& s) {
+      fixtures::rng r(1);
+      const checksum256 chain_id = r.digest();
+
+      // add_or_assert: receipt digest
+      auto ap = std::make_shared<bridge::actionproof>(fixtures::make_actionproof(r, fixtures::make_xfer(r), 6));
+      s.add("receipt_digest", [ap]() {
+         std::vector<char> serialized = pack(ap->receipt);
+         keep(sha256(serialized.data(), serialized.size()));
+      });
+
+      s.add("action_digest", [ap]() {
+         keep(merkle::action_digest(ap->action, ap->returnvalue));
+      });
+
+      s.add("unpack_xfer", [ap]() {
+         keep(unpack<wraptoken::xfer>(ap->action.data));
+      });
+
+      for (size_t depth : { 4, 8, 16 }) {
+         auto proof = std::make_shared<bridge::actionproof>(fixtures::make_actionproof(r, fixtures::make_xfer(r), depth));
+         s.add("amproof_root/depth=" + std::to_string(depth), [proof]() {
+            keep(merkle::compute_root(proof->amproofpath, merkle::receipt_digest(proof->receipt)));
+         });
+      }
+
+      for (size_t ext : { 0, 256, 1024, 4096 }) {
+         fixtures::proof_shape shape;
+         shape.extension_bytes = ext;
+         auto header = std::make_shared<bridge::blockheader>(fixtures::make_header(r, 250000000, shape));
+         s.add("header_digest/ext=" + std::to_string(ext), [header]() { keep(header->digest()); });
+         s.add("header_block_id/ext=" + std::to_string(ext), [header]() { keep(header->block_id()); });
+      }
+
+      {
+         fixtures::proof_shape shape;
+         shape.new_producers = true;
+         auto header = std::make_shared<bridge::blockheader>(fixtures::make_header(r, 250000000, shape));
+         s.add("header_digest/schedule=21", [header]() { keep(header->digest()); });
+      }
+
+      const checksum256 digest = r.digest();
+      const checksum256 id = bridge::compute_block_id(digest, 250000000);
+      s.add("compute_block_id", [digest]() { keep(bridge::compute_block_id(digest, 250000000)); });
+
+      // the byte at a time derivation compute_block_id used before, for comparison
+      s.add("compute_block_id_bytewise", [digest]() {
+         uint8_t fullraw[32] = {0};
+         uint32_t r_block_num = bridge::reverse_bytes(250000000);
+         std::array<uint8_t, 32> ab = digest.extract_as_byte_array();
+         memcpy(&fullraw[0], (uint8_t *)&r_block_num, 4);
+         for (int i = 4; i < 32; i++) memcpy(&fullraw[i], (uint8_t *)&ab[i], 1);
+         keep(checksum256(fullraw));
+      });
+      s.add("get_block_num_from_id", [id]() { keep(bridge::get_block_num_from_id(id)); });
+      s.add("reverse_bytes", []() {
+         static volatile uint32_t input = 250000000;
+         keep(bridge::reverse_bytes(input));
+      });
+
+      for (size_t bft : { 4, 12, 24 }) {
+         fixtures::proof_shape shape;
+         shape.bft_length = bft;
+         auto hp = std::make_shared<bridge::heavyproof>(fixtures::make_heavyproof(r, chain_id, fixtures::make_header(r, 250000000, shape), shape));
+         auto packed = std::make_shared<std::vector<char>>(pack(*hp));
+         s.add("pack_heavyproof/bft=" + std::to_string(bft), [hp]() { keep(pack(*hp)); });
+         s.add("unpack_heavyproof/bft=" + std::to_string(bft), [packed]() { keep(unpack<bridge::heavyproof>(*packed)); });
+      }
+
+      // a verification walk over a heavy proof: every header is asked for its id, its block number, the digest it signs and the
+      // id of the header before it, with and without memoized headers
+      for (size_t bft : { 12, 24 }) {
+         fixtures::proof_shape shape;
+         shape.bft_length = bft;
+         auto hp = std::make_shared<bridge::heavyproof>(fixtures::make_heavyproof(r, chain_id, fixtures::make_header(r, 250000000, shape), shape));
+
+         s.add("header_walk/bft=" + std::to_string(bft), [hp]() {
+            const bridge::blockheader* prior = &hp->blocktoprove.block.header;
+            keep(prior->block_id());
+            for (const bridge::sblockheader& sh : hp->bftproof) {
+               keep(sh.header.block_id());
+               keep(sh.header.block_num());
+               keep(sh.header.digest());
+               keep(prior->block_id());
+               prior = &sh.header;
+            }
+         });
+
+         s.add("header_walk_memo/bft=" + std::to_string(bft), [hp]() {
+            std::vector<blockheaders::memo> headers = blockheaders::memos(*hp);
+            keep(headers[0].id());
+            for (size_t i = 1; i < headers.size(); i++) {
+               keep(headers[i].id());
+               keep(headers[i].block_num());
+               keep(headers[i].digest());
+               keep(headers[i - 1].id());
+            }
+         });
+      }
+
+      {
+         fixtures::proof_shape shape;
+         auto lp = std::make_shared<bridge::lightproof>(fixtures::make_lightproof(r, chain_id, fixtures::make_header(r, 250000000, shape), shape));
+         auto packed = std::make_shared<std::vector<char>>(pack(*lp));
+         s.add("unpack_lightproof", [packed]() { keep(unpack<bridge::lightproof>(*packed)); });
+      }
+   }
+
+}
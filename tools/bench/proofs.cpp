@@ -0,0 +1,98 @@
+#include <bench.hpp>
+#include <accumulator.hpp>
+#include <builder.hpp>
+#include <compact.hpp>
+#include <fixtures.hpp>
+
+// proof construction by the relayer-side builder, over fixture blocks
+namespace bench {
+
+   using namespace eosio;
+
+   void register_proofs(suite& s) {
+      fixtures::rng r(2);
+      const checksum256 chain_id = r.digest();
+
+      for (size_t receipts : { 64, 1024, 8192 }) {
+         auto actions = std::make_shared<std::vector<proofs::block_action>>();
+         for (size_t i = 0; i < receipts; i++) {
+            bridge::actionproof ap = fixtures::make_actionproof(r, fixtures::make_xfer(r), 0);
+            actions->push_back(proofs::block_action{ ap.action, ap.receipt, ap.returnvalue });
+         }
+         auto wanted = std::make_shared<std::vector<size_t>>(std::vector<size_t>{ 0, receipts / 2, receipts - 1 });
+
+         for (size_t threads : { 1, 4 }) {
+            s.add("build_actionproofs/receipts=" + std::to_string(receipts) + "/threads=" + std::to_string(threads), [actions, wanted, threads]() {
+               std::vector<bridge::actionproof> out;
+               keep(proofs::build_actionproofs(*actions, *wanted, out, threads));
+            });
+         }
+      }
+
+      // block merkle of a block deep enough for a 17 level path
+      auto blockroot_merkle = std::make_shared<proofs::incremental_merkle>();
+      for (size_t i = 0; i < 100000; i++) blockroot_merkle->append(r.digest());
+
+      for (size_t later : { 0, 360, 3600 }) {
+         auto ids = std::make_shared<std::vector<checksum256>>();
+         for (size_t i = 0; i <= later; i++) ids->push_back(r.digest());
+         s.add("block_path/later=" + std::to_string(later), [blockroot_merkle, ids]() {
+            std::vector<checksum256> path;
+            keep(proofs::block_path(*blockroot_merkle, *ids, path));
+         });
+      }
+
+      s.add("incremental_merkle_append", [blockroot_merkle]() {
+         proofs::incremental_merkle copy = *blockroot_merkle;
+         copy.append(checksum256());
+         keep(copy.root());
+      });
+
+      {
+         // node store in the working directory, rebuilt on every run
+         auto store = std::make_shared<proofs::block_accumulator>("wraptoken_bench_blocks", true);
+         for (size_t i = 0; i < 100000; i++) store->append(r.digest());
+         store->flush();
+
+         auto ids = std::make_shared<fixtures::rng>(3);
+         s.add("accumulator_append", [store, ids]() { store->append(ids->digest()); });
+         s.add("accumulator_path/leaves=100000", [store]() { keep(store->path(12345, 100000)); });
+         s.add("accumulator_snapshot/leaves=99999", [store]() { keep(store->snapshot(99999)); });
+      }
+
+      {
+         // 21 producers taking turns of 12 blocks, enough headers for two rounds of 15 after the proven block
+         fixtures::proof_shape shape;
+         std::vector<name> producers;
+         for (int i = 0; i < 21; i++) producers.push_back(name(r.next() & 0xfffffffffffffff0ULL));
+
+         const uint32_t block_num = uint32_t(blockroot_merkle->node_count()) + 1;
+         auto block = std::make_shared<bridge::sblockheader>(fixtures::make_signed_header(r, block_num, shape));
+         block->header.producer = producers[0];
+
+         auto following = std::make_shared<std::vector<bridge::sblockheader>>();
+         for (uint32_t i = 1; i <= 400; i++) {
+            following->push_back(fixtures::make_signed_header(r, block_num + i, shape));
+            following->back().header.producer = producers[(i / 12) % producers.size()];
+         }
+
+         s.add("build_heavyproof/schedule=21", [chain_id, blockroot_merkle, block, following]() {
+            keep(proofs::build_heavyproof(chain_id, *block, *blockroot_merkle, *following, 21));
+         });
+
+         // compact encoding, with the packed sizes of both encodings in the benchmark names
+         auto hp = std::make_shared<bridge::heavyproof>(proofs::build_heavyproof(chain_id, *block, *blockroot_merkle, *following, 21));
+         auto cp = std::make_shared<compactproof::compactheavyproof>(proofs::compress(*hp));
+         const std::string sizes = "/bytes=" + std::to_string(pack_size(*hp)) + "->" + std::to_string(pack_size(*cp));
+         s.add("compress_heavyproof" + sizes, [hp]() { keep(proofs::compress(*hp)); });
+         s.add("expand_heavyproof" + sizes, [cp]() { keep(compactproof::expand(*cp)); });
+
+         auto later_ids = std::make_shared<std::vector<checksum256>>();
+         for (const bridge::sblockheader& sh : *following) later_ids->push_back(sh.header.block_id());
+         s.add("build_lightproof/later=400", [chain_id, blockroot_merkle, block, later_ids]() {
+            keep(proofs::build_lightproof(chain_id, block->header, *blockroot_merkle, *later_ids));
+         });
+      }
+   }
+
+}
@@ -0,0 +1,227 @@
+#include <accumulator.hpp>
+#include <fixtures.hpp>
+#include <runtime.hpp>
+#include <secp256k1.hpp>
+#include <sha256.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+using namespace eosio;
+
+// compares the block merkle maths of the proof library with a full tree rebuilt from every leaf, and checks the test key signer
+namespace {
+
+   uint64_t failures = 0;
+
+   void expect(bool ok, const std::string& what) {
+      if (ok) return;
+      if (failures < 20) fprintf(stderr, "mismatch: %s\n", what.c_str());
+      failures++;
+   }
+
+   std::string describe(const char* what, uint64_t n, uint64_t base = 0, uint32_t stride = 0, uint64_t leaf = 0) {
+      return std::string(what) + " n=" + std::to_string(n) + " base=" + std::to_string(base) + " stride=" + std::to_string(stride)
+             + " leaf=" + std::to_string(leaf);
+   }
+
+   // every level of the tree over `n` leaves as nodeos builds it, with the last node of an odd level paired with itself
+   struct full_tree {
+      std::vector<std::vector<checksum256>>   levels;
+      std::vector<std::vector<checksum256>>   paths;
+      checksum256                             root;
+
+      full_tree(const std::vector<checksum256>& ids, uint64_t n) {
+         std::vector<checksum256> leaves(ids.begin(), ids.begin() + n);
+         root = fixtures::merkle_tree(leaves, paths);
+
+         levels.push_back(leaves);
+         while (levels.back().size() > 1) {
+            std::vector<checksum256> level = levels.back();
+            if (level.size() % 2) level.push_back(level.back());
+            std::vector<checksum256> next(level.size() / 2);
+            for (size_t i = 0; i < next.size(); i++) next[i] = merkle::hash_canonical(level[2 * i], level[2 * i + 1]);
+            levels.push_back(std::move(next));
+         }
+      }
+
+      // the complete left node of every set bit of the node count from the leaves up, then the root unless it is one of them
+      std::vector<checksum256> active_nodes() const {
+         const uint64_t n = levels[0].size();
+         std::vector<checksum256> nodes;
+         for (uint32_t height = 0; height < levels.size(); height++) {
+            if ((n >> height) & 1) nodes.push_back(levels[height][(n >> height) - 1]);
+         }
+         if (n & (n - 1)) nodes.push_back(root);
+         return nodes;
+      }
+   };
+
+   bool same(const proofs::incremental_merkle& m, const full_tree& t) {
+      return m.node_count() == t.levels[0].size() && m.active_nodes() == t.active_nodes() && m.root() == t.root;
+   }
+
+   // tree sizes checked leaf by leaf, around the powers of two where the shape of the tree changes
+   std::vector<uint64_t> sizes(uint64_t exhaustive, uint64_t max) {
+      std::vector<uint64_t> result;
+      for (uint64_t n = 1; n <= exhaustive; n++) result.push_back(n);
+      for (uint64_t p = 128; p <= max; p <<= 1) {
+         for (uint64_t n : { p - 1, p, p + 1 }) {
+            if (n > exhaustive && n <= max) result.push_back(n);
+         }
+      }
+      return result;
+   }
+
+   // leaves whose paths are compared: all of them in small trees, the edges and a spread in large ones
+   std::vector<uint64_t> leaves(uint64_t first, uint64_t n) {
+      std::vector<uint64_t> result;
+      if (n - first <= 64) {
+         for (uint64_t leaf = first; leaf < n; leaf++) result.push_back(leaf);
+         return result;
+      }
+      for (uint64_t leaf = first; leaf < n; leaf += (n - first) / 16) result.push_back(leaf);
+      result.push_back(first + 1);
+      result.push_back(n - 2);
+      result.push_back(n - 1);
+      std::sort(result.begin(), result.end());
+      return result;
+   }
+
+   const uint64_t MAX_LEAVES = 4097;
+
+   void check_incremental(const std::vector<checksum256>& ids, const std::map<uint64_t, full_tree>& trees) {
+      proofs::incremental_merkle m;
+      for (uint64_t n = 1; n <= MAX_LEAVES; n++) {
+         m.append(ids[n - 1]);
+         auto t = trees.find(n);
+         if (t != trees.end()) expect(same(m, t->second), describe("incremental_merkle", n));
+      }
+      printf("incremental_merkle   %zu tree sizes\n", trees.size());
+   }
+
+   void check_block_path(const std::vector<checksum256>& ids, const std::map<uint64_t, full_tree>& trees) {
+      uint64_t paths = 0;
+      for (const auto& [n, tree] : trees) {
+         proofs::incremental_merkle before;
+         uint64_t first = 0;
+         for (uint64_t leaf : leaves(0, n)) {
+            for (; first < leaf; first++) before.append(ids[first]);
+
+            std::vector<checksum256> later(ids.begin() + leaf, ids.begin() + n);
+            std::vector<checksum256> path;
+            const checksum256 root = proofs::block_path(before, later, path);
+            expect(root == tree.root, describe("block_path root", n, 0, 0, leaf));
+            expect(path == tree.paths[leaf], describe("block_path path", n, 0, 0, leaf));
+            paths++;
+         }
+      }
+      printf("block_path           %llu paths\n", (unsigned long long)paths);
+   }
+
+   // a store restored from the block merkle after `base` leaves, so the seeds are exercised, then appended to MAX_LEAVES
+   void check_accumulator(const std::vector<checksum256>& ids, const std::map<uint64_t, full_tree>& trees, const std::string& prefix,
+                          uint64_t base, uint32_t stride, uint64_t& paths) {
+      {
+         proofs::block_accumulator store(prefix, true, stride);
+         if (base > 0) {
+            proofs::incremental_merkle snapshot;
+            for (uint64_t i = 0; i < base; i++) snapshot.append(ids[i]);
+            store.restore(snapshot);
+         }
+         for (uint64_t i = base; i < MAX_LEAVES; i++) store.append(ids[i]);
+         store.flush();
+
+         for (const auto& [n, tree] : trees) {
+            if (n < base) continue;
+            expect(same(store.snapshot(n), tree), describe("accumulator snapshot", n, base, stride));
+            expect(store.root(n) == tree.root, describe("accumulator root", n, base, stride));
+            if (n == base) continue;
+
+            for (uint64_t leaf : leaves(base, n)) {
+               expect(store.path(leaf, n) == tree.paths[leaf], describe("accumulator path", n, base, stride, leaf));
+               paths++;
+            }
+         }
+      }
+
+      // a reopened store rebuilds its head from the files alone
+      proofs::block_accumulator reopened(prefix, false);
+      const full_tree& head = trees.at(MAX_LEAVES);
+      expect(same(reopened.snapshot(), head), describe("reopened accumulator head", MAX_LEAVES, base, stride));
+      for (uint64_t leaf : leaves(base, MAX_LEAVES)) {
+         expect(reopened.path(leaf, MAX_LEAVES) == head.paths[leaf], describe("reopened accumulator path", MAX_LEAVES, base, stride, leaf));
+      }
+   }
+
+   // the test key signer: the public key of 1 is the generator, and every signature is canonical and recovers its signer
+   void check_signatures() {
+      runtime::k1_private_key one{};
+      one[31] = 1;
+      const runtime::k1_public_key generator = runtime::k1_public(one);
+      expect(generator[0] == 0x02 && generator[1] == 0x79 && generator[2] == 0xbe && generator[32] == 0x98, "k1 public key of 1");
+
+      const uint64_t keys = 64;
+      for (uint64_t i = 0; i < keys; i++) {
+         const runtime::k1_private_key key = runtime::k1_test_key(&i, sizeof(i));
+         const std::array<uint8_t, 32> digest = runtime::sha256_digest(key.data(), key.size());
+         const runtime::k1_signature sig = runtime::k1_sign(key, digest);
+
+         runtime::k1_public_key recovered;
+         const bool ok = runtime::k1_recover(digest, sig, recovered);
+         expect(ok && recovered == runtime::k1_public(key), "k1 recover key=" + std::to_string(i));
+         expect(!(sig[1] & 0x80) && !(sig[33] & 0x80), "k1 canonical key=" + std::to_string(i));
+         expect(runtime::k1_sign(key, digest) == sig, "k1 deterministic key=" + std::to_string(i));
+      }
+      printf("k1 signatures        %llu keys\n", (unsigned long long)keys);
+   }
+
+   int usage(const char* self) {
+      printf("usage: %s [--prefix <node store path>]\n", self);
+      return 1;
+   }
+
+}
+
+int main(int argc, char** argv) {
+   runtime::install_crypto();
+
+   std::string prefix = "wraptoken_check.merkle";
+   for (int i = 1; i < argc; i++) {
+      if (!strcmp(argv[i], "--prefix") && i + 1 < argc) prefix = argv[++i];
+      else return usage(argv[0]);
+   }
+
+   fixtures::rng r(3);
+   std::vector<checksum256> ids(MAX_LEAVES);
+   for (checksum256& id : ids) id = r.digest();
+
+   std::map<uint64_t, full_tree> trees;
+   for (uint64_t n : sizes(80, MAX_LEAVES)) trees.emplace(n, full_tree(ids, n));
+
+   check_signatures();
+   check_incremental(ids, trees);
+   check_block_path(ids, trees);
+
+   uint64_t paths = 0, stores = 0;
+   for (uint64_t base : { 0, 1, 2, 3, 5, 8, 13, 37, 64, 100, 255, 1025 }) {
+      for (uint32_t stride : { 1, 2, 3, 4, 5 }) {
+         check_accumulator(ids, trees, prefix, base, stride, paths);
+         stores++;
+      }
+   }
+   printf("block_accumulator    %llu stores, %llu paths\n", (unsigned long long)stores, (unsigned long long)paths);
+
+   for (uint32_t height = 0; height < 64; height++) std::remove((prefix + ".level" + std::to_string(height)).c_str());
+   std::remove((prefix + ".base").c_str());
+
+   if (failures) {
+      printf("%llu mismatches\n", (unsigned long long)failures);
+      return 1;
+   }
+   printf("all match\n");
+   return 0;
+}
@@ -0,0 +1,207 @@
+#include <corpus.hpp>
+#include <locks.hpp>
+
+#include <algorithm>
+#include <deque>
+
+namespace corpus {
+
+   using namespace eosio;
+
+   namespace {
+
+      const uint32_t CORPUS_MAGIC = 0x50435457;   // "WTCP"
+      const size_t FOOTER_SIZE = sizeof(uint64_t) * 2 + sizeof(uint32_t);
+
+      void write_exact(FILE* f, const void* data, size_t size) {
+         check(size == 0 || fwrite(data, size, 1, f) == 1, "write to corpus failed");
+      }
+
+      void read_exact(FILE* f, void* data, size_t size) {
+         check(size == 0 || fread(data, size, 1, f) == 1, "corpus is truncated");
+      }
+
+   }
+
+   writer::writer(const std::string& path, const corpus_info& info) {
+      _file = fopen(path.c_str(), "wb");
+      check(_file != nullptr, "cannot create corpus");
+
+      const std::vector<char> packed = pack(info);
+      const uint32_t size = uint32_t(packed.size());
+      write_exact(_file, &CORPUS_MAGIC, sizeof(CORPUS_MAGIC));
+      write_exact(_file, &size, sizeof(size));
+      write_exact(_file, packed.data(), packed.size());
+      _position = sizeof(CORPUS_MAGIC) + sizeof(size) + packed.size();
+   }
+
+   writer::~writer() {
+      if (_file) fclose(_file);
+   }
+
+   void writer::append(const entry& e) {
+      const std::vector<char> packed = pack(e);
+      const uint32_t size = uint32_t(packed.size());
+      _offsets.push_back(_position);
+      write_exact(_file, &size, sizeof(size));
+      write_exact(_file, packed.data(), packed.size());
+      _position += sizeof(size) + packed.size();
+   }
+
+   void writer::finish() {
+      const uint64_t count = _offsets.size();
+      write_exact(_file, _offsets.data(), _offsets.size() * sizeof(uint64_t));
+      write_exact(_file, &count, sizeof(count));
+      write_exact(_file, &_position, sizeof(_position));
+      write_exact(_file, &CORPUS_MAGIC, sizeof(CORPUS_MAGIC));
+      fclose(_file);
+      _file = nullptr;
+   }
+
+   reader::reader(const std::string& path) {
+      _file = fopen(path.c_str(), "rb");
+      check(_file != nullptr, "corpus does not exist");
+
+      uint32_t magic = 0, size = 0;
+      read_exact(_file, &magic, sizeof(magic));
+      check(magic == CORPUS_MAGIC, "not a corpus");
+      read_exact(_file, &size, sizeof(size));
+      _buffer.resize(size);
+      read_exact(_file, _buffer.data(), size);
+      _info = unpack<corpus_info>(_buffer);
+
+      uint64_t count = 0, index_offset = 0;
+      check(fseek(_file, -long(FOOTER_SIZE), SEEK_END) == 0, "corpus is truncated");
+      read_exact(_file, &count, sizeof(count));
+      read_exact(_file, &index_offset, sizeof(index_offset));
+      read_exact(_file, &magic, sizeof(magic));
+      check(magic == CORPUS_MAGIC, "corpus was not finished");
+
+      _offsets.resize(count);
+      check(fseek(_file, long(index_offset), SEEK_SET) == 0, "corpus is truncated");
+      read_exact(_file, _offsets.data(), count * sizeof(uint64_t));
+   }
+
+   reader::~reader() {
+      if (_file) fclose(_file);
+   }
+
+   const std::vector<char>& reader::raw(uint64_t index) {
+      check(index < _offsets.size(), "no such corpus entry");
+      check(fseek(_file, long(_offsets[index]), SEEK_SET) == 0, "corpus is truncated");
+
+      uint32_t size = 0;
+      read_exact(_file, &size, sizeof(size));
+      _buffer.resize(size);
+      read_exact(_file, _buffer.data(), size);
+      return _buffer;
+   }
+
+   entry reader::at(uint64_t index) {
+      return unpack<entry>(raw(index));
+   }
+
+   uint64_t generate(const std::string& path, const proofs::chain_options& chain_options, const corpus_options& options) {
+      proofs::synthetic_chain chain(chain_options);
+
+      corpus_info info;
+      info.seed = chain_options.seed;
+      info.chain_id = chain.chain_id();
+      info.wraplock_contract = chain.wraplock_contract();
+      info.token_contract = fixtures::TOKEN;
+      info.prover = options.prover;
+      info.accounts = chain.accounts();
+      info.symbols = chain.symbols();
+
+      writer out(path, info);
+
+      proofs::block_accumulator store(path + ".merkle", true);
+      store.restore(chain.start());
+
+      const bool heavy = options.proofs != proof_kind::light;
+      const bool light = options.proofs != proof_kind::heavy;
+      check(!light || options.anchor_every > 0, "light proofs need anchors");
+      check(chain_options.producers > 1, "heavy proofs need producer turns to reach finality");
+
+      std::deque<proofs::lock_block> pending;
+      std::deque<uint32_t> anchors;                 // anchor blocks whose heavy proof is not written yet
+      std::deque<bridge::sblockheader> headers;     // from the oldest pending block or anchor on
+      uint64_t anchor = 0;                          // last anchor with its heavy proof written, light proofs are checked against it
+
+      auto is_account = [&](const name& account) {
+         return std::find(info.accounts.begin(), info.accounts.end(), account) != info.accounts.end();
+      };
+
+      auto write = [&](const proofs::lock_block& p, const bridge::heavyproof* hp, const bridge::lightproof* lp) {
+         const time_point_sec block_time = p.block_time();
+         for (bool cancel : { false, true }) {
+            for (const bridge::actionproof& ap : cancel ? p.cancels : p.issues) {
+               if (hp) out.append(entry{ cancel ? "cancela"_n : "issuea"_n, p.block_num, block_time, pack(std::make_tuple(options.prover, *hp, ap)) });
+               if (lp) out.append(entry{ cancel ? "cancelb"_n : "issueb"_n, p.block_num, block_time, pack(std::make_tuple(options.prover, *lp, ap)) });
+            }
+         }
+      };
+
+      for (uint32_t i = 1; i <= options.blocks || !pending.empty(); i++) {
+         // blocks after the requested ones only carry the headers and anchors the last locks need
+         proofs::synthetic_block block = chain.next(i <= options.blocks ? chain_options.locks_per_block : 0);
+         const uint32_t block_num = block.header.header.block_num();
+         store.append(block.header.header.block_id());
+         if (light && i % options.anchor_every == 0) anchors.push_back(block_num);
+
+         std::vector<size_t> wanted;
+         for (size_t a = 0; a < block.actions.size(); a++) {
+            if (block.actions[a].action.account == chain.wraplock_contract() && block.actions[a].action.name == "emitxfer"_n) wanted.push_back(a);
+         }
+
+         if (!pending.empty() || !anchors.empty() || !wanted.empty()) headers.push_back(block.header);
+
+         if (!wanted.empty()) {
+            std::vector<bridge::actionproof> proven;
+            proofs::build_actionproofs(block.actions, wanted, proven, 1);
+            pending.push_back(proofs::make_lock_block(block.header, proven, is_account));
+         }
+
+         // the heavy proof of an anchor records its block merkle root in the bridge, so it is written before the light proofs
+         // checked against that root
+         while (!anchors.empty()) {
+            const uint32_t first = headers.front().header.block_num();
+            const bridge::sblockheader& anchor_header = headers[anchors.front() - first];
+
+            bridge::heavyproof hp;
+            if (!proofs::try_prove_heavy(store, chain.chain_id(), anchor_header, headers, first, chain_options.producers, hp)) break;
+
+            out.append(entry{ "checkproofd"_n, anchors.front(), time_point_sec(anchor_header.header.timestamp.to_time_point()), pack(hp) });
+            anchor = anchors.front();
+            anchors.pop_front();
+         }
+
+         // blocks are written in order, a block that cannot be proven yet holds back the ones after it
+         while (!pending.empty()) {
+            const proofs::lock_block& p = pending.front();
+            const uint32_t first = headers.front().header.block_num();
+
+            if (light && anchor < p.block_num) break;
+
+            bridge::heavyproof hp;
+            if (heavy && !proofs::try_prove_heavy(store, chain.chain_id(), p.header, headers, first, chain_options.producers, hp)) break;
+
+            bridge::lightproof lp;
+            if (light) lp = proofs::prove_light(store, chain.chain_id(), p.header.header, anchor);
+
+            write(p, heavy ? &hp : nullptr, light ? &lp : nullptr);
+            pending.pop_front();
+         }
+
+         uint32_t keep = block_num + 1;
+         if (!pending.empty()) keep = std::min(keep, pending.front().block_num);
+         if (!anchors.empty()) keep = std::min(keep, anchors.front());
+         while (!headers.empty() && headers.front().header.block_num() < keep) headers.pop_front();
+      }
+
+      const uint64_t count = out.size();
+      out.finish();
+      return count;
+   }
+
+}
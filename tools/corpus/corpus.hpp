@@ -0,0 +1,100 @@
+#pragma once
+
+#include <synthetic.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// corpus of ready to push issue and cancel actions proving the locks of a synthetic native chain, for load tests
+namespace corpus {
+
+   using eosio::checksum256;
+   using eosio::name;
+
+   // one action of the corpus. `data` is the packed action data, the prover followed by the block proof and the action proof of
+   // one lock, so it can be pushed as is or unpacked into a std::tuple<name, heavyproof or lightproof, actionproof>.
+   // checkproofd entries are for the bridge contract instead: their data is the heavy proof of an anchor block, which records the
+   // block merkle root the light proofs after it are checked against, so they must be pushed in corpus order.
+   struct entry {
+      name                   action;        // issuea, issueb, cancela, cancelb or checkproofd
+      uint32_t               block_num;
+      eosio::time_point_sec  block_time;
+      std::vector<char>      data;
+
+      EOSLIB_SERIALIZE( entry, (action)(block_num)(block_time)(data) )
+   };
+
+   // what a load test needs to set up the contract for the corpus
+   struct corpus_info {
+      uint64_t                    seed = 0;
+      checksum256                 chain_id;             // the native chain
+      name                        wraplock_contract;
+      name                        token_contract;
+      name                        prover;
+      std::vector<name>           accounts;             // beneficiaries that exist, cancelled locks go to other accounts
+      std::vector<eosio::symbol>  symbols;
+
+      EOSLIB_SERIALIZE( corpus_info, (seed)(chain_id)(wraplock_contract)(token_contract)(prover)(accounts)(symbols) )
+   };
+
+   // corpus file: a magic, the packed corpus_info, each entry as a length and the packed entry, then the offset of every entry
+   // and a footer with the entry count and the offset of that index, so any entry can be read without scanning the file
+   class writer {
+      public:
+         writer(const std::string& path, const corpus_info& info);
+         ~writer();
+
+         writer(const writer&) = delete;
+         writer& operator=(const writer&) = delete;
+
+         void append(const entry& e);
+
+         // writes the index and the footer, the corpus is unreadable until then
+         void finish();
+
+         uint64_t size() const { return _offsets.size(); }
+
+      private:
+         FILE*                   _file = nullptr;
+         std::vector<uint64_t>   _offsets;
+         uint64_t                _position = 0;
+   };
+
+   class reader {
+      public:
+         explicit reader(const std::string& path);
+         ~reader();
+
+         reader(const reader&) = delete;
+         reader& operator=(const reader&) = delete;
+
+         const corpus_info& info() const { return _info; }
+         uint64_t size() const { return _offsets.size(); }
+
+         // packed entry `index`, for load tests that forward the bytes without decoding them
+         const std::vector<char>& raw(uint64_t index);
+         entry at(uint64_t index);
+
+      private:
+         FILE*                   _file = nullptr;
+         corpus_info             _info;
+         std::vector<uint64_t>   _offsets;
+         std::vector<char>       _buffer;
+   };
+
+   // block proofs attached to every lock
+   enum class proof_kind : uint8_t { heavy, light, both };
+
+   struct corpus_options {
+      uint32_t     blocks = 1000;            // blocks with locks, more blocks follow until every lock can be proven
+      proof_kind   proofs = proof_kind::both;
+      uint32_t     anchor_every = 240;       // blocks between the anchors whose block merkle roots light proofs are checked against
+      name         prover = "relayer"_n;
+   };
+
+   // writes the corpus of `chain` to `path`, the on-disk block merkle is kept in files starting with `path`.merkle
+   uint64_t generate(const std::string& path, const proofs::chain_options& chain, const corpus_options& options);
+
+}
@@ -0,0 +1,96 @@
+#include <corpus.hpp>
+#include <runtime.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace eosio;
+
+namespace {
+
+   int usage(const char* self) {
+      printf("usage: %s generate <corpus> [--blocks <n>] [--locks <per block>] [--symbols <n>] [--beneficiaries <n>] [--producers <n>]\n", self);
+      printf("       %*s [--am-depth <d>] [--bm-depth <d>] [--proofs heavy|light|both] [--anchor-every <blocks>]\n", int(strlen(self) + 9), "");
+      printf("       %*s [--missing-every <locks>] [--seed <n>]\n", int(strlen(self) + 9), "");
+      printf("       %s show <corpus> [--entry <index>]\n", self);
+      return 1;
+   }
+
+   int generate(int argc, char** argv) {
+      const std::string path = argv[2];
+      proofs::chain_options chain;
+      corpus::corpus_options options;
+      uint32_t am_depth = 5;
+      uint32_t bm_depth = 27;
+
+      for (int i = 3; i < argc; i++) {
+         if (!strcmp(argv[i], "--blocks") && i + 1 < argc) options.blocks = uint32_t(strtoul(argv[++i], nullptr, 10));
+         else if (!strcmp(argv[i], "--locks") && i + 1 < argc) chain.locks_per_block = strtoull(argv[++i], nullptr, 10);
+         else if (!strcmp(argv[i], "--symbols") && i + 1 < argc) chain.symbols = strtoull(argv[++i], nullptr, 10);
+         else if (!strcmp(argv[i], "--beneficiaries") && i + 1 < argc) chain.beneficiaries = strtoull(argv[++i], nullptr, 10);
+         else if (!strcmp(argv[i], "--producers") && i + 1 < argc) chain.producers = strtoull(argv[++i], nullptr, 10);
+         else if (!strcmp(argv[i], "--am-depth") && i + 1 < argc) am_depth = uint32_t(strtoul(argv[++i], nullptr, 10));
+         else if (!strcmp(argv[i], "--bm-depth") && i + 1 < argc) bm_depth = uint32_t(strtoul(argv[++i], nullptr, 10));
+         else if (!strcmp(argv[i], "--anchor-every") && i + 1 < argc) options.anchor_every = uint32_t(strtoul(argv[++i], nullptr, 10));
+         else if (!strcmp(argv[i], "--missing-every") && i + 1 < argc) chain.missing_every = uint32_t(strtoul(argv[++i], nullptr, 10));
+         else if (!strcmp(argv[i], "--seed") && i + 1 < argc) chain.seed = strtoull(argv[++i], nullptr, 10);
+         else if (!strcmp(argv[i], "--proofs") && i + 1 < argc) {
+            const char* kind = argv[++i];
+            if (!strcmp(kind, "heavy")) options.proofs = corpus::proof_kind::heavy;
+            else if (!strcmp(kind, "light")) options.proofs = corpus::proof_kind::light;
+            else if (!strcmp(kind, "both")) options.proofs = corpus::proof_kind::both;
+            else return usage(argv[0]);
+         }
+         else return usage(argv[0]);
+      }
+
+      if (am_depth > 20 || bm_depth < 1 || bm_depth > 31) return usage(argv[0]);
+
+      // every block has 2^am_depth receipts, and 2^bm_depth blocks before the first one
+      const size_t receipts = size_t(1) << am_depth;
+      chain.other_actions = receipts > chain.locks_per_block ? receipts - chain.locks_per_block : 0;
+      chain.first_block = (1u << bm_depth) + 1;
+
+      const uint64_t count = corpus::generate(path, chain, options);
+      printf("wrote %llu entries to %s\n", (unsigned long long)count, path.c_str());
+      return 0;
+   }
+
+   void print_entry(corpus::reader& in, uint64_t index) {
+      const std::vector<char>& raw = in.raw(index);
+      const corpus::entry e = unpack<corpus::entry>(raw);
+      printf("%8llu  %-11s block %u  %s  %zu bytes\n", (unsigned long long)index, e.action.to_string().c_str(), e.block_num,
+             e.block_time.to_string().c_str(), e.data.size());
+   }
+
+   int show(int argc, char** argv) {
+      corpus::reader in(argv[2]);
+      const corpus::corpus_info& info = in.info();
+
+      printf("seed %llu, %llu entries, %zu accounts, %zu symbols, wraplock %s, token %s, prover %s\n", (unsigned long long)info.seed,
+             (unsigned long long)in.size(), info.accounts.size(), info.symbols.size(), info.wraplock_contract.to_string().c_str(),
+             info.token_contract.to_string().c_str(), info.prover.to_string().c_str());
+
+      for (int i = 3; i < argc; i++) {
+         if (!strcmp(argv[i], "--entry") && i + 1 < argc) {
+            print_entry(in, strtoull(argv[++i], nullptr, 10));
+            return 0;
+         }
+         return usage(argv[0]);
+      }
+
+      for (uint64_t i = 0; i < in.size(); i++) print_entry(in, i);
+      return 0;
+   }
+
+}
+
+int main(int argc, char** argv) {
+   runtime::install_crypto();
+
+   if (argc >= 3 && !strcmp(argv[1], "generate")) return generate(argc, argv);
+   if (argc >= 3 && !strcmp(argv[1], "show")) return show(argc, argv);
+
+   return usage(argv[0]);
+}
@@ -0,0 +1,165 @@
+#include <fixtures.hpp>
+
+namespace fixtures {
+
+   using namespace eosio;
+
+   uint64_t rng::next() {
+      _state ^= _state << 13;
+      _state ^= _state >> 7;
+      _state ^= _state << 17;
+      return _state;
+   }
+
+   checksum256 rng::digest() {
+      std::array<uint8_t, 32> arr;
+      for (size_t i = 0; i < arr.size(); i += 8) {
+         uint64_t v = next();
+         memcpy(arr.data() + i, &v, 8);
+      }
+      return checksum256(arr);
+   }
+
+   checksum256 rng::canonical_digest(bool left) {
+      return left ? merkle::make_canonical_left(digest()) : merkle::make_canonical_right(digest());
+   }
+
+   wraptoken::xfer make_xfer(rng& r) {
+      static const char* const symbols[] = { "EOS", "USDT", "WAX", "TLOS" };
+      symbol sym(symbol_code(symbols[r.next() % 4]), 4);
+      return wraptoken::xfer{
+         .owner = name(r.next() & 0xfffffffffffffff0ULL),
+         .quantity = extended_asset(asset(int64_t(r.next() % 10000000000ULL) + 1, sym), TOKEN),
+         .beneficiary = name(r.next() & 0xfffffffffffffff0ULL)
+      };
+   }
+
+   bridge::blockheader make_header(rng& r, uint32_t block_num, const proof_shape& shape) {
+      bridge::blockheader h;
+      h.timestamp = block_timestamp(time_point(microseconds(int64_t(1700000000 + block_num / 2) * 1000000)));
+      h.producer = name(r.next() & 0xfffffffffffffff0ULL);
+      h.confirmed = 0;
+      h.previous = bridge::compute_block_id(r.digest(), block_num - 1);
+      h.transaction_mroot = r.digest();
+      h.action_mroot = r.digest();
+      h.schedule_version = 42;
+
+      if (shape.new_producers) {
+         producer_schedule schedule{ 43, {} };
+         for (int i = 0; i < 21; i++) {
+            schedule.producers.push_back(producer_key{ name(r.next() & 0xfffffffffffffff0ULL), public_key(std::in_place_index<0>, ecc_public_key{}) });
+         }
+         h.new_producers = schedule;
+      }
+
+      if (shape.extension_bytes > 0) {
+         std::vector<char> payload(shape.extension_bytes);
+         for (char& c : payload) c = char(r.next());
+         h.header_extensions.emplace_back(uint16_t(1), payload);
+      }
+
+      return h;
+   }
+
+   bridge::sblockheader make_signed_header(rng& r, uint32_t block_num, const proof_shape& shape) {
+      bridge::sblockheader sh;
+      sh.header = make_header(r, block_num, shape);
+      sh.producer_signatures.push_back(signature(std::in_place_index<0>, ecc_signature{}));
+      sh.previous_bmroot = r.digest();
+      for (size_t i = 0; i < shape.bm_depth; i++) sh.bmproofpath.push_back(uint16_t(i));
+      return sh;
+   }
+
+   bridge::actionproof make_actionproof(rng& r, const wraptoken::xfer& xfer, size_t am_depth) {
+      bridge::actionproof ap;
+      ap.action.account = WRAPLOCK;
+      ap.action.name = "emitxfer"_n;
+      ap.action.authorization.push_back(permission_level{ WRAPLOCK, "active"_n });
+      ap.action.data = pack(xfer);
+
+      ap.receipt.receiver = WRAPLOCK;
+      ap.receipt.act_digest = merkle::action_digest(ap.action, ap.returnvalue);
+      ap.receipt.global_sequence = r.next() >> 16;
+      ap.receipt.recv_sequence = r.next() >> 32;
+      ap.receipt.auth_sequence.push_back(bridge::authseq{ WRAPLOCK, r.next() >> 32 });
+      ap.receipt.code_sequence = 3;
+      ap.receipt.abi_sequence = 3;
+
+      for (size_t i = 0; i < am_depth; i++) ap.amproofpath.push_back(r.canonical_digest(r.next() & 1));
+      return ap;
+   }
+
+   bridge::heavyproof make_heavyproof(rng& r, const checksum256& chain_id, const bridge::blockheader& header, const proof_shape& shape) {
+      bridge::heavyproof hp;
+      hp.chain_id = chain_id;
+      for (size_t i = 0; i < shape.bm_depth; i++) hp.hashes.push_back(r.canonical_digest(r.next() & 1));
+
+      uint32_t block_num = header.block_num();
+      hp.blocktoprove.block = make_signed_header(r, block_num, shape);
+      hp.blocktoprove.block.header = header;
+      for (size_t i = 0; i < shape.bm_depth; i++) hp.blocktoprove.active_nodes.push_back(uint16_t(i));
+      hp.blocktoprove.node_count = block_num - 1;
+
+      for (size_t i = 0; i < shape.bft_length; i++) hp.bftproof.push_back(make_signed_header(r, block_num + 1 + i, shape));
+      return hp;
+   }
+
+   bridge::lightproof make_lightproof(rng& r, const checksum256& chain_id, const bridge::blockheader& header, const proof_shape& shape) {
+      bridge::lightproof lp;
+      lp.chain_id = chain_id;
+      lp.header = header;
+      lp.root = r.digest();
+      for (size_t i = 0; i < shape.bm_depth; i++) lp.bmproofpath.push_back(r.canonical_digest(r.next() & 1));
+      return lp;
+   }
+
+   checksum256 merkle_tree(const std::vector<checksum256>& leaves, std::vector<std::vector<checksum256>>& paths) {
+      paths.assign(leaves.size(), {});
+      if (leaves.empty()) return checksum256();
+
+      std::vector<checksum256> level = leaves;
+      std::vector<size_t> position(leaves.size());
+      for (size_t i = 0; i < position.size(); i++) position[i] = i;
+
+      while (level.size() > 1) {
+         // odd levels pair their last node with itself
+         if (level.size() % 2) level.push_back(level.back());
+
+         for (size_t leaf = 0; leaf < leaves.size(); leaf++) {
+            size_t p = position[leaf];
+            if (p % 2) paths[leaf].push_back(merkle::make_canonical_left(level[p - 1]));
+            else paths[leaf].push_back(merkle::make_canonical_right(level[p + 1]));
+            position[leaf] = p / 2;
+         }
+
+         std::vector<checksum256> next(level.size() / 2);
+         for (size_t i = 0; i < next.size(); i++) {
+            next[i] = merkle::hash_canonical(level[2 * i], level[2 * i + 1]);
+         }
+         level.swap(next);
+      }
+
+      return level.front();
+   }
+
+   block_fixture make_block(rng& r, const checksum256& chain_id, uint32_t block_num, const std::vector<wraptoken::xfer>& xfers, const proof_shape& shape) {
+      block_fixture block;
+
+      std::vector<checksum256> leaves;
+      for (const wraptoken::xfer& x : xfers) {
+         block.actions.push_back(make_actionproof(r, x, 0));
+         leaves.push_back(merkle::receipt_digest(block.actions.back().receipt));
+      }
+      while (leaves.size() < (size_t(1) << shape.am_depth)) leaves.push_back(r.digest());
+
+      std::vector<std::vector<checksum256>> paths;
+      bridge::blockheader header = make_header(r, block_num, shape);
+      header.action_mroot = merkle_tree(leaves, paths);
+      for (size_t i = 0; i < block.actions.size(); i++) block.actions[i].amproofpath = paths[i];
+
+      block.heavy = make_heavyproof(r, chain_id, header, shape);
+      block.light = make_lightproof(r, chain_id, header, shape);
+      return block;
+   }
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <wraptoken.hpp>
+
+#include <cstdint>
+
+namespace fixtures {
+
+   using eosio::checksum256;
+   using eosio::name;
+
+   // deterministic xorshift generator, so every run measures the same proofs
+   class rng {
+      public:
+         explicit rng(uint64_t seed) : _state(seed ? seed : 0x9e3779b97f4a7c15ULL) {}
+
+         uint64_t next();
+         checksum256 digest();
+         checksum256 canonical_digest(bool left);
+
+      private:
+         uint64_t _state;
+   };
+
+   // size knobs of a generated proof
+   struct proof_shape {
+      size_t   bft_length = 12;          // signed headers in the heavy proof bftproof
+      size_t   bm_depth = 20;            // bmproofpath depth of every signed header
+      size_t   am_depth = 6;             // amproofpath depth of the action proof
+      size_t   extension_bytes = 0;      // header_extensions payload per header
+      bool     new_producers = false;    // attach a 21 producer schedule to the proven header
+   };
+
+   const name WRAPLOCK = "wraplock"_n;
+   const name TOKEN = "eosio.token"_n;
+
+   eosio::wraptoken::xfer make_xfer(rng& r);
+
+   bridge::blockheader make_header(rng& r, uint32_t block_num, const proof_shape& shape);
+   bridge::sblockheader make_signed_header(rng& r, uint32_t block_num, const proof_shape& shape);
+
+   bridge::actionproof make_actionproof(rng& r, const eosio::wraptoken::xfer& xfer, size_t am_depth);
+
+   // block proofs of `header`, with bftproof and merkle paths sized by `shape`
+   bridge::heavyproof make_heavyproof(rng& r, const checksum256& chain_id, const bridge::blockheader& header, const proof_shape& shape);
+   bridge::lightproof make_lightproof(rng& r, const checksum256& chain_id, const bridge::blockheader& header, const proof_shape& shape);
+
+   // merkle root of `leaves` as computed by nodeos, filling in the proof path of every leaf
+   checksum256 merkle_tree(const std::vector<checksum256>& leaves, std::vector<std::vector<checksum256>>& paths);
+
+   // a block whose action merkle root commits to one emitxfer per xfer, padded with other receipts to 2^am_depth leaves
+   struct block_fixture {
+      bridge::heavyproof                  heavy;
+      bridge::lightproof                  light;
+      std::vector<bridge::actionproof>    actions;
+   };
+
+   block_fixture make_block(rng& r, const checksum256& chain_id, uint32_t block_num, const std::vector<eosio::wraptoken::xfer>& xfers, const proof_shape& shape);
+
+}
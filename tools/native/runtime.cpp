@@ -0,0 +1,19 @@
+#include <runtime.hpp>
+#include <sha256.hpp>
+
+#include <eosio/tester.hpp>
+
+#include <cstring>
+
+namespace runtime {
+
+   void install_crypto() {
+      using namespace eosio::native;
+
+      intrinsics::set_intrinsic<intrinsics::sha256>([](const char* data, uint32_t length, auto* hash) {
+         std::array<uint8_t, 32> digest = sha256_digest(data, length);
+         memcpy(hash, digest.data(), digest.size());
+      });
+   }
+
+}
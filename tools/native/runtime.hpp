@@ -0,0 +1,8 @@
+#pragma once
+
+namespace runtime {
+
+   // installs native implementations of the crypto intrinsics used by the contract headers (sha256)
+   void install_crypto();
+
+}
@@ -0,0 +1,368 @@
+#include <secp256k1.hpp>
+#include <sha256.hpp>
+
+#include <cstring>
+
+namespace runtime {
+
+   namespace {
+
+      // 256 bit unsigned integer, least significant word first
+      struct u256 {
+         uint64_t w[4] = { 0, 0, 0, 0 };
+      };
+
+      typedef unsigned __int128 u128;
+
+      // a modulus 2^256 - c with c below 2^130, so products reduce by folding their high half back in multiplied by c
+      struct modulus {
+         u256 m;
+         u256 c;
+      };
+
+      const modulus P = { { { 0xFFFFFFFEFFFFFC2FULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL } },
+                          { { 0x00000001000003D1ULL, 0, 0, 0 } } };
+      const modulus N = { { { 0xBFD25E8CD0364141ULL, 0xBAAEDCE6AF48A03BULL, 0xFFFFFFFFFFFFFFFEULL, 0xFFFFFFFFFFFFFFFFULL } },
+                          { { 0x402DA1732FC9BEBFULL, 0x4551231950B75FC4ULL, 0x0000000000000001ULL, 0 } } };
+
+      const u256 GX = { { 0x59F2815B16F81798ULL, 0x029BFCDB2DCE28D9ULL, 0x55A06295CE870B07ULL, 0x79BE667EF9DCBBACULL } };
+      const u256 GY = { { 0x9C47D08FFB10D4B8ULL, 0xFD17B448A6855419ULL, 0x5DA4FBFC0E1108A8ULL, 0x483ADA7726A3C465ULL } };
+
+      u256 from_bytes(const uint8_t* be) {
+         u256 r;
+         for (int i = 0; i < 32; i++) r.w[3 - i / 8] = (r.w[3 - i / 8] << 8) | be[i];
+         return r;
+      }
+
+      void to_bytes(const u256& a, uint8_t* be) {
+         for (int i = 0; i < 32; i++) be[i] = uint8_t(a.w[3 - i / 8] >> (56 - 8 * (i % 8)));
+      }
+
+      bool is_zero(const u256& a) { return (a.w[0] | a.w[1] | a.w[2] | a.w[3]) == 0; }
+
+      int compare(const u256& a, const u256& b) {
+         for (int i = 3; i >= 0; i--) {
+            if (a.w[i] != b.w[i]) return a.w[i] < b.w[i] ? -1 : 1;
+         }
+         return 0;
+      }
+
+      bool bit(const u256& a, int i) { return (a.w[i / 64] >> (i % 64)) & 1; }
+
+      // returns the carry out
+      uint64_t add(u256& r, const u256& a, const u256& b) {
+         u128 carry = 0;
+         for (int i = 0; i < 4; i++) {
+            carry += u128(a.w[i]) + b.w[i];
+            r.w[i] = uint64_t(carry);
+            carry >>= 64;
+         }
+         return uint64_t(carry);
+      }
+
+      // returns the borrow out
+      uint64_t sub(u256& r, const u256& a, const u256& b) {
+         uint64_t borrow = 0;
+         for (int i = 0; i < 4; i++) {
+            const u128 d = u128(a.w[i]) - b.w[i] - borrow;
+            r.w[i] = uint64_t(d);
+            borrow = uint64_t(d >> 64) & 1;
+         }
+         return borrow;
+      }
+
+      void mul_wide(uint64_t* r, const u256& a, const u256& b) {
+         memset(r, 0, 8 * sizeof(uint64_t));
+         for (int i = 0; i < 4; i++) {
+            u128 carry = 0;
+            for (int j = 0; j < 4; j++) {
+               carry += u128(a.w[i]) * b.w[j] + r[i + j];
+               r[i + j] = uint64_t(carry);
+               carry >>= 64;
+            }
+            r[i + 4] = uint64_t(carry);
+         }
+      }
+
+      u256 reduce(const uint64_t* wide, const modulus& m) {
+         uint64_t x[8];
+         memcpy(x, wide, sizeof(x));
+         for (;;) {
+            u256 lo, hi;
+            memcpy(lo.w, x, sizeof(lo.w));
+            memcpy(hi.w, x + 4, sizeof(hi.w));
+            if (is_zero(hi)) {
+               while (compare(lo, m.m) >= 0) sub(lo, lo, m.m);
+               return lo;
+            }
+            // hi * 2^256 + lo = hi * c + lo (mod m)
+            mul_wide(x, hi, m.c);
+            u256 low;
+            memcpy(low.w, x, sizeof(low.w));
+            uint64_t carry = add(low, low, lo);
+            memcpy(x, low.w, sizeof(low.w));
+            for (int i = 4; i < 8 && carry; i++) carry = ++x[i] == 0;
+         }
+      }
+
+      u256 add_mod(const u256& a, const u256& b, const modulus& m) {
+         u256 r;
+         if (add(r, a, b) || compare(r, m.m) >= 0) sub(r, r, m.m);
+         return r;
+      }
+
+      u256 sub_mod(const u256& a, const u256& b, const modulus& m) {
+         u256 r;
+         if (sub(r, a, b)) add(r, r, m.m);
+         return r;
+      }
+
+      u256 mul_mod(const u256& a, const u256& b, const modulus& m) {
+         uint64_t wide[8];
+         mul_wide(wide, a, b);
+         return reduce(wide, m);
+      }
+
+      u256 pow_mod(const u256& a, const u256& e, const modulus& m) {
+         u256 r = { { 1, 0, 0, 0 } };
+         for (int i = 255; i >= 0; i--) {
+            r = mul_mod(r, r, m);
+            if (bit(e, i)) r = mul_mod(r, a, m);
+         }
+         return r;
+      }
+
+      // inverse by Fermat's little theorem, both moduli are prime
+      u256 inverse(const u256& a, const modulus& m) {
+         u256 e;
+         sub(e, m.m, u256{ { 2, 0, 0, 0 } });
+         return pow_mod(a, e, m);
+      }
+
+      // curve point in jacobian coordinates, z = 0 is the point at infinity
+      struct point {
+         u256 x, y, z;
+      };
+
+      point affine(const u256& x, const u256& y) { return point{ x, y, u256{ { 1, 0, 0, 0 } } }; }
+
+      point twice(const point& p) {
+         if (is_zero(p.z) || is_zero(p.y)) return point{};
+         const u256 yy = mul_mod(p.y, p.y, P);
+         const u256 xyy = mul_mod(p.x, yy, P);
+         const u256 s = add_mod(add_mod(xyy, xyy, P), add_mod(xyy, xyy, P), P);
+         const u256 xx = mul_mod(p.x, p.x, P);
+         const u256 m = add_mod(add_mod(xx, xx, P), xx, P);
+         point r;
+         r.x = sub_mod(mul_mod(m, m, P), add_mod(s, s, P), P);
+         u256 yyyy8 = mul_mod(yy, yy, P);
+         for (int i = 0; i < 3; i++) yyyy8 = add_mod(yyyy8, yyyy8, P);
+         r.y = sub_mod(mul_mod(m, sub_mod(s, r.x, P), P), yyyy8, P);
+         const u256 yz = mul_mod(p.y, p.z, P);
+         r.z = add_mod(yz, yz, P);
+         return r;
+      }
+
+      point sum(const point& a, const point& b) {
+         if (is_zero(a.z)) return b;
+         if (is_zero(b.z)) return a;
+         const u256 za2 = mul_mod(a.z, a.z, P);
+         const u256 zb2 = mul_mod(b.z, b.z, P);
+         const u256 u1 = mul_mod(a.x, zb2, P);
+         const u256 u2 = mul_mod(b.x, za2, P);
+         const u256 s1 = mul_mod(a.y, mul_mod(zb2, b.z, P), P);
+         const u256 s2 = mul_mod(b.y, mul_mod(za2, a.z, P), P);
+         if (compare(u1, u2) == 0) return compare(s1, s2) == 0 ? twice(a) : point{};
+
+         const u256 h = sub_mod(u2, u1, P);
+         const u256 r = sub_mod(s2, s1, P);
+         const u256 h2 = mul_mod(h, h, P);
+         const u256 h3 = mul_mod(h2, h, P);
+         const u256 u1h2 = mul_mod(u1, h2, P);
+         point out;
+         out.x = sub_mod(sub_mod(mul_mod(r, r, P), h3, P), add_mod(u1h2, u1h2, P), P);
+         out.y = sub_mod(mul_mod(r, sub_mod(u1h2, out.x, P), P), mul_mod(s1, h3, P), P);
+         out.z = mul_mod(h, mul_mod(a.z, b.z, P), P);
+         return out;
+      }
+
+      point multiply(const point& p, const u256& k) {
+         point r;
+         for (int i = 255; i >= 0; i--) {
+            r = twice(r);
+            if (bit(k, i)) r = sum(r, p);
+         }
+         return r;
+      }
+
+      // affine coordinates of a point that is not at infinity
+      void normalize(const point& p, u256& x, u256& y) {
+         const u256 zi = inverse(p.z, P);
+         const u256 zi2 = mul_mod(zi, zi, P);
+         x = mul_mod(p.x, zi2, P);
+         y = mul_mod(p.y, mul_mod(zi2, zi, P), P);
+      }
+
+      k1_public_key compress(const point& p) {
+         u256 x, y;
+         normalize(p, x, y);
+         k1_public_key out;
+         out[0] = uint8_t(0x02 | (y.w[0] & 1));
+         to_bytes(x, out.data() + 1);
+         return out;
+      }
+
+      // digest as a scalar, the digest is exactly as wide as the group order
+      u256 scalar_of(const std::array<uint8_t, 32>& digest) {
+         u256 e = from_bytes(digest.data());
+         if (compare(e, N.m) >= 0) sub(e, e, N.m);
+         return e;
+      }
+
+      std::array<uint8_t, 32> hmac(const std::array<uint8_t, 32>& key, const uint8_t* data, size_t size) {
+         uint8_t pad[64];
+         sha256_hasher inner;
+         memset(pad, 0x36, sizeof(pad));
+         for (size_t i = 0; i < key.size(); i++) pad[i] ^= key[i];
+         inner.update(pad, sizeof(pad));
+         inner.update(data, size);
+         const std::array<uint8_t, 32> inner_digest = inner.finish();
+
+         sha256_hasher outer;
+         memset(pad, 0x5c, sizeof(pad));
+         for (size_t i = 0; i < key.size(); i++) pad[i] ^= key[i];
+         outer.update(pad, sizeof(pad));
+         outer.update(inner_digest.data(), inner_digest.size());
+         return outer.finish();
+      }
+
+      // the nonce candidates of RFC 6979 section 3.2 for HMAC-SHA256, in order
+      class rfc6979 {
+         public:
+            rfc6979(const k1_private_key& key, const std::array<uint8_t, 32>& digest) {
+               _v.fill(0x01);
+               _k.fill(0x00);
+               uint8_t h1[32];
+               to_bytes(scalar_of(digest), h1);
+               for (uint8_t round : { 0x00, 0x01 }) {
+                  uint8_t seed[32 + 1 + 32 + 32];
+                  memcpy(seed, _v.data(), 32);
+                  seed[32] = round;
+                  memcpy(seed + 33, key.data(), 32);
+                  memcpy(seed + 65, h1, 32);
+                  _k = hmac(_k, seed, sizeof(seed));
+                  _v = hmac(_k, _v.data(), _v.size());
+               }
+            }
+
+            u256 next() {
+               for (;;) {
+                  if (_started) {
+                     uint8_t seed[33];
+                     memcpy(seed, _v.data(), 32);
+                     seed[32] = 0x00;
+                     _k = hmac(_k, seed, sizeof(seed));
+                     _v = hmac(_k, _v.data(), _v.size());
+                  }
+                  _started = true;
+                  _v = hmac(_k, _v.data(), _v.size());
+                  const u256 k = from_bytes(_v.data());
+                  if (!is_zero(k) && compare(k, N.m) < 0) return k;
+               }
+            }
+
+         private:
+            std::array<uint8_t, 32>   _k;
+            std::array<uint8_t, 32>   _v;
+            bool                      _started = false;
+      };
+
+      // eosio only accepts signatures whose r and s need no sign padding in DER
+      bool is_canonical(const k1_signature& c) {
+         return !(c[1] & 0x80) && !(c[1] == 0 && !(c[2] & 0x80)) && !(c[33] & 0x80) && !(c[33] == 0 && !(c[34] & 0x80));
+      }
+
+   }
+
+   k1_private_key k1_test_key(const void* seed, size_t size) {
+      std::array<uint8_t, 32> key = sha256_digest(seed, size);
+      for (;;) {
+         const u256 d = from_bytes(key.data());
+         if (!is_zero(d) && compare(d, N.m) < 0) return key;
+         key = sha256_digest(key.data(), key.size());
+      }
+   }
+
+   k1_public_key k1_public(const k1_private_key& key) {
+      return compress(multiply(affine(GX, GY), from_bytes(key.data())));
+   }
+
+   k1_signature k1_sign(const k1_private_key& key, const std::array<uint8_t, 32>& digest) {
+      const u256 d = from_bytes(key.data());
+      const u256 e = scalar_of(digest);
+      u256 half;
+      for (int i = 0; i < 4; i++) half.w[i] = (N.m.w[i] >> 1) | (i < 3 ? N.m.w[i + 1] << 63 : 0);
+
+      rfc6979 nonces(key, digest);
+      for (;;) {
+         const u256 k = nonces.next();
+         u256 rx, ry;
+         normalize(multiply(affine(GX, GY), k), rx, ry);
+
+         uint8_t recovery = uint8_t(ry.w[0] & 1);
+         u256 r = rx;
+         if (compare(r, N.m) >= 0) {
+            sub(r, r, N.m);
+            recovery |= 2;
+         }
+         if (is_zero(r)) continue;
+
+         u256 s = mul_mod(inverse(k, N), add_mod(e, mul_mod(r, d, N), N), N);
+         if (is_zero(s)) continue;
+         if (compare(s, half) > 0) {
+            sub(s, N.m, s);
+            recovery ^= 1;
+         }
+
+         k1_signature sig;
+         sig[0] = uint8_t(27 + 4 + recovery);
+         to_bytes(r, sig.data() + 1);
+         to_bytes(s, sig.data() + 33);
+         if (is_canonical(sig)) return sig;
+      }
+   }
+
+   bool k1_recover(const std::array<uint8_t, 32>& digest, const k1_signature& sig, k1_public_key& out) {
+      if (sig[0] < 27 || sig[0] >= 27 + 8) return false;
+      const uint8_t recovery = (sig[0] - 27) & 3;
+
+      const u256 r = from_bytes(sig.data() + 1);
+      const u256 s = from_bytes(sig.data() + 33);
+      if (is_zero(r) || compare(r, N.m) >= 0 || is_zero(s) || compare(s, N.m) >= 0) return false;
+
+      u256 x = r;
+      if (recovery & 2) {
+         if (add(x, x, N.m) || compare(x, P.m) >= 0) return false;
+      }
+
+      // y^2 = x^3 + 7, and p = 3 mod 4 gives the square root as a power
+      const u256 rhs = add_mod(mul_mod(mul_mod(x, x, P), x, P), u256{ { 7, 0, 0, 0 } }, P);
+      u256 exponent;
+      add(exponent, P.m, u256{ { 1, 0, 0, 0 } });
+      for (int i = 0; i < 4; i++) exponent.w[i] = (exponent.w[i] >> 2) | (i < 3 ? exponent.w[i + 1] << 62 : 0);
+      u256 y = pow_mod(rhs, exponent, P);
+      if (compare(mul_mod(y, y, P), rhs) != 0) return false;
+      if ((y.w[0] & 1) != (recovery & 1)) sub(y, P.m, y);
+
+      // Q = r^-1 (s R - e G)
+      const u256 ri = inverse(r, N);
+      const u256 u1 = sub_mod(u256{}, mul_mod(scalar_of(digest), ri, N), N);
+      const u256 u2 = mul_mod(s, ri, N);
+      const point q = sum(multiply(affine(GX, GY), u1), multiply(affine(x, y), u2));
+      if (is_zero(q.z)) return false;
+
+      out = compress(q);
+      return true;
+   }
+
+}
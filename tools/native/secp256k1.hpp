@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace runtime {
+
+   // secp256k1 ECDSA as nodeos signs block headers, for the deterministic test keys of synthetic chains. The arithmetic is
+   // neither constant time nor fast, it must never see a real key.
+   using k1_private_key = std::array<uint8_t, 32>;
+   using k1_public_key = std::array<uint8_t, 33>;    // compressed point
+   using k1_signature = std::array<uint8_t, 65>;     // 27 + 4 + recovery id, then r and s, as in an eosio ecc_signature
+
+   // private key derived from the sha256 of `seed`, the same seed always gives the same key
+   k1_private_key k1_test_key(const void* seed, size_t size);
+
+   k1_public_key k1_public(const k1_private_key& key);
+
+   // canonical low-s signature of `digest` with an RFC 6979 nonce, so signing is deterministic
+   k1_signature k1_sign(const k1_private_key& key, const std::array<uint8_t, 32>& digest);
+
+   // public key whose private key signed `digest`, returns false when `sig` is not a valid signature
+   bool k1_recover(const std::array<uint8_t, 32>& digest, const k1_signature& sig, k1_public_key& out);
+
+}
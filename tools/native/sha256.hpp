@@ -0,0 +1,28 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace runtime {
+
+   // portable SHA-256, installed as the `sha256` intrinsic for native builds
+   class sha256_hasher {
+      public:
+         sha256_hasher();
+
+         void update(const void* data, size_t size);
+         std::array<uint8_t, 32> finish();
+
+      private:
+         void transform(const uint8_t* block);
+
+         uint32_t  _state[8];
+         uint8_t   _buffer[64];
+         uint64_t  _length = 0;
+         size_t    _buffered = 0;
+   };
+
+   std::array<uint8_t, 32> sha256_digest(const void* data, size_t size);
+
+}
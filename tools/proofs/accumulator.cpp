@@ -0,0 +1,214 @@
+#include <accumulator.hpp>
+
+namespace proofs {
+
+   using namespace eosio;
+
+   namespace {
+
+      constexpr long RECORD_SIZE = 32;
+
+      // height of the tree over `node_count` leaves, 0 for a single leaf
+      uint32_t tree_height(uint64_t node_count) {
+         uint32_t height = 0;
+         while ((uint64_t(1) << height) < node_count) height++;
+         return height;
+      }
+
+      std::string level_name(const std::string& prefix, uint32_t height) {
+         return prefix + ".level" + std::to_string(height);
+      }
+
+   }
+
+   block_accumulator::block_accumulator(const std::string& prefix, bool create, uint32_t stride) : _prefix(prefix), _stride(stride) {
+      check(stride > 0 && stride < 64, "invalid node store stride");
+
+      if (create) {
+         for (uint32_t height = 0; height < 64; height++) std::remove(level_name(_prefix, height).c_str());
+         write_base();
+         return;
+      }
+
+      FILE* f = fopen((_prefix + ".base").c_str(), "rb");
+      check(f != nullptr, "node store does not exist");
+
+      uint64_t node_count = 0;
+      uint32_t count = 0;
+      bool ok = fread(&_stride, sizeof(_stride), 1, f) == 1 && fread(&node_count, sizeof(node_count), 1, f) == 1 && fread(&count, sizeof(count), 1, f) == 1;
+
+      std::vector<checksum256> active_nodes;
+      for (uint32_t i = 0; ok && i < count; i++) {
+         std::array<uint8_t, 32> arr;
+         ok = fread(arr.data(), arr.size(), 1, f) == 1;
+         active_nodes.emplace_back(arr);
+      }
+      fclose(f);
+      check(ok, "node store base is corrupt");
+
+      restore(incremental_merkle(std::move(active_nodes), node_count));
+
+      FILE* leaves = level_file(0);
+      fseek(leaves, 0, SEEK_END);
+      const uint64_t stored = uint64_t(ftell(leaves)) / RECORD_SIZE;
+      if (stored > 0) _head = build_snapshot(node_count + stored);
+   }
+
+   block_accumulator::~block_accumulator() {
+      for (auto& file : _files) fclose(file.second);
+   }
+
+   void block_accumulator::restore(const incremental_merkle& snapshot) {
+      check(_head.node_count() == _base.node_count(), "can only restore an empty node store");
+
+      _base = snapshot;
+      _head = snapshot;
+
+      // the active nodes are the complete left nodes the next leaf pairs with, one per set bit of the node count, then the root
+      _seeds.clear();
+      const uint64_t n = snapshot.node_count();
+      size_t next = 0;
+      for (uint32_t height = 0; height < 64; height++) {
+         if (!((n >> height) & 1)) continue;
+         check(next < snapshot.active_nodes().size(), "snapshot is missing active nodes");
+         _seeds[{ height, (n >> height) - 1 }] = snapshot.active_nodes()[next++];
+      }
+
+      write_base();
+   }
+
+   void block_accumulator::append(const checksum256& id) {
+      const uint64_t index = _head.node_count();
+
+      std::vector<checksum256> lefts;
+      _head.append(id, &lefts);
+
+      // every level where the new leaf's ancestor is a right node completes a node one level up
+      checksum256 current = id;
+      write_node(0, index, current);
+      auto left = lefts.cbegin();
+      for (uint32_t height = 0; (index >> height) & 1; height++) {
+         current = merkle::hash_canonical(*left++, current);
+         write_node(height + 1, index >> (height + 1), current);
+      }
+   }
+
+   incremental_merkle block_accumulator::snapshot(uint64_t node_count) const {
+      check(node_count >= first_leaf(), "block merkle before the first leaf is not stored");
+      check(node_count <= this->node_count(), "no such block merkle");
+      return build_snapshot(node_count);
+   }
+
+   incremental_merkle block_accumulator::build_snapshot(uint64_t node_count) const {
+      if (node_count == first_leaf()) return _base;
+
+      std::vector<checksum256> active_nodes;
+      for (uint32_t height = 0; height < 64; height++) {
+         if ((node_count >> height) & 1) active_nodes.push_back(complete_node(height, (node_count >> height) - 1));
+      }
+      // a power of two leaves has its root as the last left node already
+      if (node_count & (node_count - 1)) active_nodes.push_back(node(tree_height(node_count), 0, node_count));
+
+      return incremental_merkle(std::move(active_nodes), node_count);
+   }
+
+   checksum256 block_accumulator::root(uint64_t node_count) const {
+      check(node_count > 0 && node_count <= this->node_count(), "no such block merkle");
+      if (node_count == first_leaf()) return _base.root();
+      return node(tree_height(node_count), 0, node_count);
+   }
+
+   std::vector<checksum256> block_accumulator::path(uint64_t leaf, uint64_t node_count) const {
+      check(leaf >= first_leaf(), "block precedes the accumulator start");
+      check(leaf < node_count && node_count <= this->node_count(), "block is not in the block merkle");
+
+      std::vector<checksum256> result;
+      for (uint32_t height = 0; ; height++) {
+         const uint64_t level_size = ((node_count - 1) >> height) + 1;
+         if (level_size == 1) break;
+
+         const uint64_t position = leaf >> height;
+         if (position & 1) result.push_back(merkle::make_canonical_left(node(height, position - 1, node_count)));
+         else if (position + 1 < level_size) result.push_back(merkle::make_canonical_right(node(height, position + 1, node_count)));
+         else result.push_back(merkle::make_canonical_right(node(height, position, node_count)));   // odd level, paired with itself
+      }
+      return result;
+   }
+
+   void block_accumulator::flush() {
+      for (auto& file : _files) fflush(file.second);
+   }
+
+   checksum256 block_accumulator::complete_node(uint32_t height, uint64_t index) const {
+      auto seed = _seeds.find({ height, index });
+      if (seed != _seeds.end()) return seed->second;
+
+      const uint64_t first = index << height;
+      if (first < first_leaf()) {
+         // only nodes overlapping the first leaf can be rebuilt from seeds and stored nodes
+         check(height > 0 && first + (uint64_t(1) << height) > first_leaf(), "block precedes the accumulator start");
+      }
+      else if (height % _stride == 0) {
+         FILE* f = level_file(height);
+         std::array<uint8_t, 32> arr;
+         fseek(f, long((index - level_offset(height)) * RECORD_SIZE), SEEK_SET);
+         check(fread(arr.data(), arr.size(), 1, f) == 1, "node is not stored");
+         return checksum256(arr);
+      }
+
+      return merkle::hash_canonical(complete_node(height - 1, 2 * index), complete_node(height - 1, 2 * index + 1));
+   }
+
+   checksum256 block_accumulator::node(uint32_t height, uint64_t index, uint64_t node_count) const {
+      const uint64_t first = index << height;
+      if (height == 0 || first + (uint64_t(1) << height) <= node_count) return complete_node(height, index);
+
+      // a node on the right edge of the tree, whose missing right half is implied to equal its left half
+      const checksum256 left = node(height - 1, 2 * index, node_count);
+      const uint64_t right_first = (2 * index + 1) << (height - 1);
+      return merkle::hash_canonical(left, right_first < node_count ? node(height - 1, 2 * index + 1, node_count) : left);
+   }
+
+   uint64_t block_accumulator::level_offset(uint32_t height) const {
+      // first node of the level that lies entirely after the first leaf
+      return (first_leaf() + (uint64_t(1) << height) - 1) >> height;
+   }
+
+   FILE* block_accumulator::level_file(uint32_t height) const {
+      auto itr = _files.find(height);
+      if (itr != _files.end()) return itr->second;
+
+      const std::string name = level_name(_prefix, height);
+      FILE* f = fopen(name.c_str(), "r+b");
+      if (f == nullptr) f = fopen(name.c_str(), "w+b");
+      check(f != nullptr, "unable to open node store");
+      _files[height] = f;
+      return f;
+   }
+
+   void block_accumulator::write_node(uint32_t height, uint64_t index, const checksum256& node) {
+      if (height % _stride != 0 || index < level_offset(height)) return;
+
+      FILE* f = level_file(height);
+      std::array<uint8_t, 32> arr = node.extract_as_byte_array();
+      fseek(f, long((index - level_offset(height)) * RECORD_SIZE), SEEK_SET);
+      check(fwrite(arr.data(), arr.size(), 1, f) == 1, "unable to write node store");
+   }
+
+   void block_accumulator::write_base() {
+      FILE* f = fopen((_prefix + ".base").c_str(), "wb");
+      check(f != nullptr, "unable to write node store base");
+
+      const uint64_t node_count = _base.node_count();
+      const uint32_t count = uint32_t(_base.active_nodes().size());
+      fwrite(&_stride, sizeof(_stride), 1, f);
+      fwrite(&node_count, sizeof(node_count), 1, f);
+      fwrite(&count, sizeof(count), 1, f);
+      for (const checksum256& node : _base.active_nodes()) {
+         std::array<uint8_t, 32> arr = node.extract_as_byte_array();
+         fwrite(arr.data(), arr.size(), 1, f);
+      }
+      fclose(f);
+   }
+
+}
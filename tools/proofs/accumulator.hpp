@@ -0,0 +1,64 @@
+#pragma once
+
+#include <builder.hpp>
+
+#include <cstdio>
+#include <map>
+#include <string>
+
+namespace proofs {
+
+   // incremental block merkle tree backed by a node store on disk, so the block merkle state and bmproofpath of any block
+   // appended to it can be produced later without replaying the chain. Leaf `i` is the id of block `i + 1` for a chain
+   // accumulated from genesis, matching the node_count of a nodeos blockroot_merkle.
+   //
+   // Only complete nodes of every `stride`-th level are stored, as fixed size records in one file per level. Other nodes are
+   // rehashed from the closest stored level below them, at most 2^stride - 1 hashes.
+   class block_accumulator {
+      public:
+         // opens the store with files starting with `prefix`, or creates an empty one, truncating any existing files, if `create`
+         block_accumulator(const std::string& prefix, bool create, uint32_t stride = 4);
+         ~block_accumulator();
+
+         block_accumulator(const block_accumulator&) = delete;
+         block_accumulator& operator=(const block_accumulator&) = delete;
+
+         // starts an empty store from the block merkle of a chain that is not accumulated from genesis, blocks before the
+         // snapshot can then not be proven
+         void restore(const incremental_merkle& snapshot);
+
+         void append(const checksum256& id);
+
+         uint64_t node_count() const { return _head.node_count(); }
+         uint64_t first_leaf() const { return _base.node_count(); }
+
+         // block merkle after the first `node_count` leaves, usable as the active_nodes and node_count of an anchor block
+         incremental_merkle snapshot(uint64_t node_count) const;
+         const incremental_merkle& snapshot() const { return _head; }
+
+         checksum256 root(uint64_t node_count) const;
+
+         // path from `leaf` to root(node_count), as used in a bmproofpath
+         std::vector<checksum256> path(uint64_t leaf, uint64_t node_count) const;
+
+         void flush();
+
+      private:
+         incremental_merkle build_snapshot(uint64_t node_count) const;
+         checksum256 complete_node(uint32_t height, uint64_t index) const;
+         checksum256 node(uint32_t height, uint64_t index, uint64_t node_count) const;
+
+         uint64_t level_offset(uint32_t height) const;
+         FILE* level_file(uint32_t height) const;
+         void write_node(uint32_t height, uint64_t index, const checksum256& node);
+         void write_base();
+
+         std::string                                         _prefix;
+         uint32_t                                            _stride;
+         incremental_merkle                                  _base;
+         incremental_merkle                                  _head;
+         std::map<std::pair<uint32_t, uint64_t>, checksum256> _seeds;   // complete nodes before the first leaf, from the base snapshot
+         mutable std::map<uint32_t, FILE*>                   _files;
+   };
+
+}
@@ -0,0 +1,259 @@
+#include <builder.hpp>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <thread>
+
+namespace proofs {
+
+   using namespace eosio;
+
+   namespace {
+
+      // height of a tree over `node_count` leaves, counting the leaves as one level
+      uint64_t max_depth(uint64_t node_count) {
+         if (node_count == 0) return 0;
+         uint64_t implied = 1;
+         while (implied < node_count) implied <<= 1;
+         uint64_t depth = 1;
+         while (implied > 1) {
+            implied >>= 1;
+            depth++;
+         }
+         return depth;
+      }
+
+      // root of the subtree of `height` levels over ids[begin, end), which is the right edge of its tree when partial
+      checksum256 subtree_root(const std::vector<checksum256>& ids, size_t begin, size_t end, uint64_t height) {
+         std::vector<checksum256> level(ids.begin() + begin, ids.begin() + end);
+         for (uint64_t h = 0; h < height; h++) {
+            if (level.size() % 2) level.push_back(level.back());
+            for (size_t i = 0; i < level.size() / 2; i++) level[i] = merkle::hash_canonical(level[2 * i], level[2 * i + 1]);
+            level.resize(level.size() / 2);
+         }
+         return level.front();
+      }
+
+      template <typename F>
+      void parallel_for(size_t count, size_t threads, const F& fn) {
+         if (threads == 0) threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+         threads = std::min(threads, count);
+
+         if (threads <= 1) {
+            for (size_t i = 0; i < count; i++) fn(i);
+            return;
+         }
+
+         const size_t chunk = (count + threads - 1) / threads;
+         std::vector<std::thread> workers;
+         for (size_t begin = 0; begin < count; begin += chunk) {
+            const size_t end = std::min(count, begin + chunk);
+            workers.emplace_back([&fn, begin, end]() {
+               for (size_t i = begin; i < end; i++) fn(i);
+            });
+         }
+         for (std::thread& w : workers) w.join();
+      }
+
+   }
+
+   void incremental_merkle::append(const checksum256& digest, std::vector<checksum256>* lefts) {
+      bool partial = false;
+      uint64_t depth = max_depth(_node_count + 1);
+      uint64_t index = _node_count;
+      checksum256 top = digest;
+
+      auto active = _active_nodes.cbegin();
+      std::vector<checksum256> updated;
+      updated.reserve(depth);
+
+      for (; depth > 1; depth--, index >>= 1) {
+         if (!(index & 1)) {
+            // a left node with an implied right node equal to itself, only kept while fully realized
+            if (!partial) updated.push_back(top);
+            top = merkle::hash_canonical(top, top);
+            partial = true;
+         } else {
+            // a right node paired with the fully realized left node kept from earlier appends
+            const checksum256& left = *active++;
+            if (lefts) lefts->push_back(left);
+            if (partial) updated.push_back(left);
+            top = merkle::hash_canonical(left, top);
+         }
+      }
+
+      updated.push_back(top);
+      _active_nodes.swap(updated);
+      _node_count++;
+   }
+
+   checksum256 block_path(const incremental_merkle& before, const std::vector<checksum256>& ids, std::vector<checksum256>& path) {
+      check(!ids.empty(), "no block id to prove");
+      path.clear();
+
+      // the left siblings of the first id are the nodes it is paired with when appended
+      std::vector<checksum256> lefts;
+      incremental_merkle tree = before;
+      tree.append(ids.front(), &lefts);
+
+      const uint64_t first = before.node_count();
+      const uint64_t total = first + ids.size();
+
+      checksum256 current = ids.front();
+      uint64_t position = first;
+      uint64_t level_size = total;
+      auto left = lefts.cbegin();
+
+      for (uint64_t height = 0; level_size > 1; height++, position >>= 1, level_size = (level_size + 1) / 2) {
+         if (position & 1) {
+            path.push_back(merkle::make_canonical_left(*left));
+            current = merkle::hash_canonical(*left++, current);
+         } else {
+            // the right sibling covers later ids, or is the node itself at the end of an odd level
+            checksum256 right = current;
+            if (position + 1 < level_size) {
+               const uint64_t begin = (position + 1) << height;
+               const uint64_t end = std::min((position + 2) << height, total);
+               right = subtree_root(ids, begin - first, end - first, height);
+            }
+            path.push_back(merkle::make_canonical_right(right));
+            current = merkle::hash_canonical(current, right);
+         }
+      }
+
+      return current;
+   }
+
+   checksum256 build_actionproofs(const std::vector<block_action>& actions, const std::vector<size_t>& wanted,
+                                  std::vector<bridge::actionproof>& out, size_t threads) {
+      check(!actions.empty(), "block has no action receipts");
+
+      std::vector<std::vector<checksum256>> levels(1);
+      levels[0].resize(actions.size());
+      parallel_for(actions.size(), threads, [&](size_t i) {
+         levels[0][i] = merkle::receipt_digest(actions[i].receipt);
+      });
+
+      while (levels.back().size() > 1) {
+         std::vector<checksum256>& level = levels.back();
+         if (level.size() % 2) level.push_back(level.back());
+
+         std::vector<checksum256> next(level.size() / 2);
+         // small levels are not worth a thread start
+         parallel_for(next.size(), next.size() >= 1024 ? threads : 1, [&](size_t i) {
+            next[i] = merkle::hash_canonical(level[2 * i], level[2 * i + 1]);
+         });
+         levels.push_back(std::move(next));
+      }
+
+      out.clear();
+      out.reserve(wanted.size());
+      for (size_t w : wanted) {
+         check(w < actions.size(), "wanted receipt is not in the block");
+
+         bridge::actionproof proof;
+         proof.action = actions[w].action;
+         proof.receipt = actions[w].receipt;
+         proof.returnvalue = actions[w].returnvalue;
+
+         size_t position = w;
+         for (size_t l = 0; l + 1 < levels.size(); l++, position >>= 1) {
+            if (position & 1) proof.amproofpath.push_back(merkle::make_canonical_left(levels[l][position - 1]));
+            else proof.amproofpath.push_back(merkle::make_canonical_right(levels[l][position + 1]));
+         }
+         out.push_back(std::move(proof));
+      }
+
+      return levels.back().front();
+   }
+
+   bridge::lightproof build_lightproof(const checksum256& chain_id, const bridge::blockheader& header,
+                                       const incremental_merkle& blockroot_merkle, const std::vector<checksum256>& later_ids) {
+      std::vector<checksum256> ids;
+      ids.reserve(later_ids.size() + 1);
+      ids.push_back(header.block_id());
+      ids.insert(ids.end(), later_ids.begin(), later_ids.end());
+
+      bridge::lightproof lp;
+      lp.chain_id = chain_id;
+      lp.header = header;
+      lp.root = block_path(blockroot_merkle, ids, lp.bmproofpath);
+      return lp;
+   }
+
+   std::vector<size_t> select_bft(const bridge::sblockheader& block, const std::vector<bridge::sblockheader>& following, size_t schedule_size) {
+      std::vector<size_t> selected;
+      check(try_select_bft(block, following, schedule_size, selected), "not enough headers after the block to reach finality");
+      return selected;
+   }
+
+   bool try_select_bft(const bridge::sblockheader& block, const std::vector<bridge::sblockheader>& following, size_t schedule_size,
+                       std::vector<size_t>& selected) {
+      const size_t required = schedule_size * 2 / 3 + 1;
+
+      selected.clear();
+      std::set<uint64_t> producers;
+      size_t rounds = 0;
+      name last = block.header.producer;
+
+      for (size_t i = 0; i < following.size(); i++) {
+         const name producer = following[i].header.producer;
+         if (producer == last) continue;
+         last = producer;
+
+         selected.push_back(i);
+         producers.insert(producer.value);
+         if (producers.size() < required) continue;
+
+         if (++rounds == 2) return true;
+         producers.clear();
+      }
+
+      return false;
+   }
+
+   bridge::heavyproof build_heavyproof(const checksum256& chain_id, const bridge::sblockheader& block, const incremental_merkle& blockroot_merkle,
+                                       const std::vector<bridge::sblockheader>& following, size_t schedule_size) {
+      bridge::heavyproof hp;
+      hp.chain_id = chain_id;
+
+      std::map<checksum256, uint16_t> positions;
+      auto index_of = [&](const checksum256& hash) {
+         auto [itr, inserted] = positions.try_emplace(hash, uint16_t(hp.hashes.size()));
+         if (inserted) {
+            check(hp.hashes.size() < 0x10000, "too many hashes for a heavy proof");
+            hp.hashes.push_back(hash);
+         }
+         return itr->second;
+      };
+
+      hp.blocktoprove.block = block;
+      hp.blocktoprove.block.previous_bmroot = blockroot_merkle.root();
+      hp.blocktoprove.block.bmproofpath.clear();
+      for (const checksum256& node : blockroot_merkle.active_nodes()) hp.blocktoprove.active_nodes.push_back(index_of(node));
+      hp.blocktoprove.node_count = blockroot_merkle.node_count();
+
+      const std::vector<size_t> selected = select_bft(block, following, schedule_size);
+
+      // ids of the proven block and every header up to the last selected one
+      std::vector<checksum256> ids;
+      ids.push_back(block.header.block_id());
+      for (size_t i = 0; i < selected.back(); i++) ids.push_back(following[i].header.block_id());
+
+      std::vector<checksum256> path;
+      for (size_t s : selected) {
+         // the block merkle of a header covers the blocks before it
+         const std::vector<checksum256> covered(ids.begin(), ids.begin() + s + 1);
+
+         bridge::sblockheader sh = following[s];
+         sh.previous_bmroot = block_path(blockroot_merkle, covered, path);
+         sh.bmproofpath.clear();
+         for (const checksum256& node : path) sh.bmproofpath.push_back(index_of(node));
+         hp.bftproof.push_back(std::move(sh));
+      }
+
+      return hp;
+   }
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <wraptoken.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// builds ready to pack bridge proofs from raw block headers and action receipts, for relayers
+namespace proofs {
+
+   using eosio::checksum256;
+
+   // incremental merkle tree over block ids, as kept by nodeos in the blockroot_merkle of a block header state
+   class incremental_merkle {
+      public:
+         incremental_merkle() = default;
+         incremental_merkle(std::vector<checksum256> active_nodes, uint64_t node_count)
+            : _active_nodes(std::move(active_nodes)), _node_count(node_count) {}
+
+         // appends `digest`, filling `lefts` with the left siblings it was paired with, from the leaf up
+         void append(const checksum256& digest, std::vector<checksum256>* lefts = nullptr);
+
+         checksum256 root() const { return _node_count > 0 ? _active_nodes.back() : checksum256(); }
+
+         const std::vector<checksum256>& active_nodes() const { return _active_nodes; }
+         uint64_t node_count() const { return _node_count; }
+
+      private:
+         std::vector<checksum256>   _active_nodes;
+         uint64_t                   _node_count = 0;
+   };
+
+   // root of `before` once all of `ids` are appended to it, filling `path` with the proof path of the first of `ids`
+   checksum256 block_path(const incremental_merkle& before, const std::vector<checksum256>& ids, std::vector<checksum256>& path);
+
+   // one action receipt of a block, in the order it was committed to by the action merkle root
+   struct block_action {
+      eosio::action        action;
+      bridge::actreceipt   receipt;
+      std::vector<char>    returnvalue;
+
+      EOSLIB_SERIALIZE( block_action, (action)(receipt)(returnvalue) )
+   };
+
+   // action proofs of the `wanted` receipts of a block, returns the action merkle root. Receipt digests and the lower levels of
+   // the tree are hashed on `threads` threads, 0 for one per hardware thread.
+   checksum256 build_actionproofs(const std::vector<block_action>& actions, const std::vector<size_t>& wanted,
+                                  std::vector<bridge::actionproof>& out, size_t threads = 0);
+
+   // light proof of `header` against the block merkle root reached after the blocks with `later_ids`, where `blockroot_merkle`
+   // is the block merkle of `header` itself (covering the blocks before it)
+   bridge::lightproof build_lightproof(const checksum256& chain_id, const bridge::blockheader& header,
+                                       const incremental_merkle& blockroot_merkle, const std::vector<checksum256>& later_ids);
+
+   // positions in `following` of the headers a heavy proof needs for finality: the first header of each producer turn, until two
+   // successive sets of 2/3+1 distinct producers of a `schedule_size` schedule have produced after the proven block
+   std::vector<size_t> select_bft(const bridge::sblockheader& block, const std::vector<bridge::sblockheader>& following, size_t schedule_size);
+
+   // same as select_bft, returns false instead of failing when `following` does not reach finality yet
+   bool try_select_bft(const bridge::sblockheader& block, const std::vector<bridge::sblockheader>& following, size_t schedule_size,
+                       std::vector<size_t>& selected);
+
+   // heavy proof of `block`, where `following` are the consecutive signed headers produced after it. Active nodes and block merkle
+   // paths are stored as indices into the deduplicated `hashes` list.
+   bridge::heavyproof build_heavyproof(const checksum256& chain_id, const bridge::sblockheader& block, const incremental_merkle& blockroot_merkle,
+                                       const std::vector<bridge::sblockheader>& following, size_t schedule_size);
+
+}
@@ -0,0 +1,73 @@
+#include <compact.hpp>
+
+#include <map>
+
+namespace proofs {
+
+   using namespace eosio;
+   using compactproof::compactheader;
+
+   compactproof::compactheavyproof compress(const bridge::heavyproof& proof) {
+      compactproof::compactheavyproof cp;
+      cp.chain_id = proof.chain_id;
+
+      std::map<checksum256, uint32_t> hashes;
+      auto ref_of = [&](const checksum256& hash) {
+         const checksum256 stripped = merkle::make_canonical_left(hash);
+         auto [itr, inserted] = hashes.try_emplace(stripped, uint32_t(cp.hashes.size()));
+         if (inserted) cp.hashes.push_back(stripped);
+         return unsigned_int(itr->second * 2 + (merkle::is_canonical_left(hash) ? 0 : 1));
+      };
+
+      std::map<uint64_t, uint32_t> producers;
+      auto producer_of = [&](const name& producer) {
+         auto [itr, inserted] = producers.try_emplace(producer.value, uint32_t(cp.producers.size()));
+         if (inserted) cp.producers.push_back(producer);
+         return unsigned_int(itr->second);
+      };
+
+      auto compress_header = [&](const bridge::sblockheader& sh, const bridge::blockheader* prior) {
+         const bridge::blockheader& h = sh.header;
+         compactheader c;
+
+         const uint32_t prior_slot = prior ? prior->timestamp.slot : 0;
+         const uint32_t prior_schedule = prior ? prior->schedule_version : 0;
+         check(h.timestamp.slot >= prior_slot, "headers must be in block order");
+         check(h.schedule_version >= prior_schedule, "headers must be in block order");
+
+         c.slot_delta = unsigned_int(h.timestamp.slot - prior_slot);
+         c.producer = producer_of(h.producer);
+         c.confirmed = unsigned_int(h.confirmed);
+         if (!prior || h.previous != prior->block_id()) c.previous = h.previous;
+         c.transaction_mroot = h.transaction_mroot;
+         c.action_mroot = h.action_mroot;
+         c.schedule_delta = unsigned_int(h.schedule_version - prior_schedule);
+         c.new_producers = h.new_producers;
+         c.header_extensions = h.header_extensions;
+         c.producer_signatures = sh.producer_signatures;
+         c.previous_bmroot = ref_of(sh.previous_bmroot);
+         for (uint16_t index : sh.bmproofpath) {
+            check(index < proof.hashes.size(), "invalid hash index in proof");
+            c.bmproofpath.push_back(ref_of(proof.hashes[index]));
+         }
+
+         return c;
+      };
+
+      cp.blocktoprove = compress_header(proof.blocktoprove.block, nullptr);
+      for (uint16_t index : proof.blocktoprove.active_nodes) {
+         check(index < proof.hashes.size(), "invalid hash index in proof");
+         cp.active_nodes.push_back(ref_of(proof.hashes[index]));
+      }
+      cp.node_count = proof.blocktoprove.node_count;
+
+      const bridge::blockheader* prior = &proof.blocktoprove.block.header;
+      for (const bridge::sblockheader& sh : proof.bftproof) {
+         cp.bftproof.push_back(compress_header(sh, prior));
+         prior = &sh.header;
+      }
+
+      return cp;
+   }
+
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <wraptoken.hpp>
+
+namespace proofs {
+
+   // encodes `proof` for the `issued` and `canceld` actions, compactproof::expand rebuilds it up to the order of its hashes
+   compactproof::compactheavyproof compress(const bridge::heavyproof& proof);
+
+}
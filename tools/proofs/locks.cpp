@@ -0,0 +1,44 @@
+#include <locks.hpp>
+
+namespace proofs {
+
+   using namespace eosio;
+
+   lock_block make_lock_block(const bridge::sblockheader& header, std::vector<bridge::actionproof>& proven,
+                              const std::function<bool(const name&)>& is_account) {
+      lock_block p{ .block_num = header.header.block_num(), .header = header };
+      for (bridge::actionproof& ap : proven) {
+         const wraptoken::xfer x = unpack<wraptoken::xfer>(ap.action.data);
+         (is_account(x.beneficiary) ? p.issues : p.cancels).push_back(std::move(ap));
+      }
+      proven.clear();
+      return p;
+   }
+
+   bridge::lightproof prove_light(const block_accumulator& store, const checksum256& chain_id, const bridge::blockheader& header, uint64_t anchor) {
+      const uint32_t block_num = header.block_num();
+      check(anchor >= block_num, "anchor does not cover the block");
+
+      bridge::lightproof lp;
+      lp.chain_id = chain_id;
+      lp.header = header;
+      lp.root = store.root(anchor);
+      lp.bmproofpath = store.path(block_num - 1, anchor);
+      return lp;
+   }
+
+   bool try_prove_heavy(const block_accumulator& store, const checksum256& chain_id, const bridge::sblockheader& block,
+                        const std::deque<bridge::sblockheader>& headers, uint32_t headers_first, size_t schedule_size, bridge::heavyproof& out) {
+      const uint32_t block_num = block.header.block_num();
+      check(block_num >= headers_first && block_num - headers_first < headers.size(), "block is not in the headers");
+
+      std::vector<bridge::sblockheader> following(headers.begin() + (block_num + 1 - headers_first), headers.end());
+      std::vector<size_t> selected;
+      if (!try_select_bft(block, following, schedule_size, selected)) return false;
+
+      following.resize(selected.back() + 1);
+      out = build_heavyproof(chain_id, block, store.snapshot(block_num - 1), following, schedule_size);
+      return true;
+   }
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <accumulator.hpp>
+
+#include <deque>
+#include <functional>
+
+// scheduling of the block proofs for the emitxfer locks of a native chain, shared by the relayer and the corpus generator
+namespace proofs {
+
+   // locks of a block waiting for the headers or the anchor their block proof needs
+   struct lock_block {
+      uint32_t                           block_num = 0;
+      bridge::sblockheader               header;
+      std::vector<bridge::actionproof>   issues;
+      std::vector<bridge::actionproof>   cancels;
+
+      eosio::time_point_sec block_time() const { return eosio::time_point_sec(header.header.timestamp.to_time_point()); }
+   };
+
+   // the locks proven by `proven`, split by their beneficiary: the inline transfer of an issue fails for an account that does
+   // not exist, so those locks can only be cancelled
+   lock_block make_lock_block(const bridge::sblockheader& header, std::vector<bridge::actionproof>& proven,
+                              const std::function<bool(const eosio::name&)>& is_account);
+
+   // light proof of `header` against the block merkle root of `store` after `anchor` leaves, which must cover the block
+   bridge::lightproof prove_light(const block_accumulator& store, const checksum256& chain_id, const bridge::blockheader& header, uint64_t anchor);
+
+   // heavy proof of `block` from the consecutive signed `headers` starting at block number `headers_first` and including it,
+   // returns false when the headers after the block do not reach finality yet
+   bool try_prove_heavy(const block_accumulator& store, const checksum256& chain_id, const bridge::sblockheader& block,
+                        const std::deque<bridge::sblockheader>& headers, uint32_t headers_first, size_t schedule_size, bridge::heavyproof& out);
+
+}
@@ -0,0 +1,141 @@
+#include <synthetic.hpp>
+
+#include <cstring>
+
+namespace proofs {
+
+   using namespace eosio;
+
+   namespace {
+
+      name make_name(const char* prefix, uint64_t n) {
+         std::string s(prefix);
+         for (int i = 0; i < 4; i++, n /= 26) s += char('a' + n % 26);
+         return name(s);
+      }
+
+      symbol make_symbol(size_t i) {
+         static const char* const known[] = { "EOS", "USDT", "WAX", "TLOS" };
+         if (i < 4) return symbol(symbol_code(known[i]), 4);
+
+         std::string code = "T";
+         for (size_t n = i - 4, k = 0; k < 3; k++, n /= 26) code += char('A' + n % 26);
+         return symbol(symbol_code(code), 4);
+      }
+
+   }
+
+   synthetic_chain::synthetic_chain(const chain_options& options)
+      : _options(options), _rng(options.seed), _block_num(options.first_block) {
+      const uint64_t before = uint64_t(options.first_block) - 1;
+      check(before > 0 && (before & (before - 1)) == 0, "first block must be one past a power of two");
+      check(options.producers > 0 && options.symbols > 0 && options.beneficiaries > 0, "chain needs producers, symbols and accounts");
+
+      _chain_id = _rng.digest();
+      _start = incremental_merkle({ _rng.digest() }, before);
+      _previous = bridge::compute_block_id(_rng.digest(), before);
+
+      for (uint64_t i = 0; i < options.beneficiaries; i++) _accounts.push_back(make_name("user", i));
+      for (size_t i = 0; i < options.symbols; i++) _symbols.push_back(make_symbol(i));
+
+      _schedule.version = 1;
+      for (size_t i = 0; i < options.producers; i++) {
+         const name producer = make_name("producer", i);
+         const std::string seed = producer.to_string();
+         _keys.push_back(runtime::k1_test_key(seed.data(), seed.size()));
+
+         const runtime::k1_public_key key = runtime::k1_public(_keys.back());
+         ecc_public_key pub;
+         memcpy(pub.data(), key.data(), key.size());
+         _schedule.producers.push_back(producer_key{ producer, public_key(std::in_place_index<0>, pub) });
+      }
+
+      const std::vector<char> packed = pack(_schedule);
+      _schedule_hash = sha256(packed.data(), packed.size());
+      _blockroot_merkle = _start;
+   }
+
+   // digest a producer signs, as nodeos computes it from the header, the block merkle root before it and the schedule hash
+   checksum256 synthetic_chain::sig_digest(const bridge::blockheader& header) const {
+      const std::vector<char> header_bmroot = pack(std::make_pair(header.digest(), _blockroot_merkle.root()));
+      const std::vector<char> packed = pack(std::make_pair(sha256(header_bmroot.data(), header_bmroot.size()), _schedule_hash));
+      return sha256(packed.data(), packed.size());
+   }
+
+   bridge::actreceipt synthetic_chain::make_receipt(const action& act) {
+      bridge::actreceipt receipt;
+      receipt.receiver = act.account;
+      receipt.act_digest = merkle::action_digest(act, {});
+      receipt.global_sequence = _global_sequence++;
+      receipt.recv_sequence = _rng.next() >> 32;
+      receipt.auth_sequence.push_back(bridge::authseq{ act.authorization[0].actor, _rng.next() >> 32 });
+      receipt.code_sequence = 3;
+      receipt.abi_sequence = 3;
+      return receipt;
+   }
+
+   synthetic_block synthetic_chain::next(size_t locks) {
+      const uint32_t block_num = _block_num++;
+      synthetic_block block;
+
+      // locks spread among the receipts of other contracts
+      const size_t total = locks + _options.other_actions;
+      std::vector<bool> is_lock(total, false);
+      for (size_t placed = 0; placed < locks; ) {
+         size_t i = _rng.next() % total;
+         if (!is_lock[i]) {
+            is_lock[i] = true;
+            placed++;
+         }
+      }
+
+      std::vector<checksum256> leaves;
+      for (size_t i = 0; i < total; i++) {
+         block_action ba;
+         if (is_lock[i]) {
+            wraptoken::xfer x = {
+               .owner = _accounts[_rng.next() % _accounts.size()],
+               .quantity = extended_asset(asset(int64_t(_rng.next() % 10000000000ULL) + 1, _symbols[_rng.next() % _symbols.size()]), fixtures::TOKEN),
+               .beneficiary = _accounts[_rng.next() % _accounts.size()]
+            };
+            if (_options.missing_every && ++_lock_count % _options.missing_every == 0) x.beneficiary = make_name("gone", _rng.next());
+
+            ba.action.account = fixtures::WRAPLOCK;
+            ba.action.name = "emitxfer"_n;
+            ba.action.authorization.push_back(permission_level{ fixtures::WRAPLOCK, "active"_n });
+            ba.action.data = pack(x);
+         }
+         else {
+            ba.action.account = fixtures::TOKEN;
+            ba.action.name = "transfer"_n;
+            ba.action.authorization.push_back(permission_level{ _accounts[_rng.next() % _accounts.size()], "active"_n });
+            ba.action.data.resize(40);
+            for (char& c : ba.action.data) c = char(_rng.next());
+         }
+         ba.receipt = make_receipt(ba.action);
+         leaves.push_back(merkle::receipt_digest(ba.receipt));
+         block.actions.push_back(std::move(ba));
+      }
+
+      bridge::blockheader& h = block.header.header;
+      h.timestamp = block_timestamp(time_point(microseconds(int64_t(1700000000) * 1000000 + int64_t(block_num - _options.first_block) * 500000)));
+      const size_t producer = (block_num / _options.producer_turn) % _schedule.producers.size();
+      h.producer = _schedule.producers[producer].producer_name;
+      h.confirmed = 0;
+      h.previous = _previous;
+      h.transaction_mroot = _rng.digest();
+      h.action_mroot = merkle::tree_root(leaves);
+      h.schedule_version = _schedule.version;
+      if (block_num == _options.first_block) h.new_producers = _schedule;
+
+      const runtime::k1_signature sig = runtime::k1_sign(_keys[producer], sig_digest(h).extract_as_byte_array());
+      ecc_signature producer_signature;
+      memcpy(producer_signature.data(), sig.data(), sig.size());
+      block.header.producer_signatures.push_back(signature(std::in_place_index<0>, producer_signature));
+
+      _previous = h.block_id();
+      _blockroot_merkle.append(_previous);
+      return block;
+   }
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <builder.hpp>
+#include <fixtures.hpp>
+#include <secp256k1.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace proofs {
+
+   // size knobs of a synthetic native chain
+   struct chain_options {
+      uint64_t   seed = 1;
+      uint32_t   first_block = (1u << 27) + 1;   // one past a power of two, so the block merkle before it is a single node
+      size_t     producers = 21;
+      uint32_t   producer_turn = 12;              // consecutive blocks of each producer
+      size_t     symbols = 4;                     // distinct symbols locked
+      size_t     beneficiaries = 64;              // accounts that lock and receive tokens
+      size_t     locks_per_block = 2;
+      size_t     other_actions = 30;              // receipts of other contracts in every block, sets the action merkle depth
+      uint32_t   missing_every = 50;              // every n-th lock goes to an account that does not exist, 0 for none
+   };
+
+   // a block of the synthetic chain: its signed header and its action receipts in action merkle order
+   struct synthetic_block {
+      bridge::sblockheader          header;
+      std::vector<block_action>     actions;
+   };
+
+   // deterministic native chain with consistent block ids, action merkle roots and producer turns. The first block announces
+   // the producer schedule. Producers sign with test keys derived from their names, over the schedule hash of `schedule()`, so
+   // a bridge initialized with that schedule accepts their signatures.
+   class synthetic_chain {
+      public:
+         explicit synthetic_chain(const chain_options& options);
+
+         const checksum256& chain_id() const { return _chain_id; }
+         const eosio::name& wraplock_contract() const { return fixtures::WRAPLOCK; }
+
+         // block merkle before the first block
+         const incremental_merkle& start() const { return _start; }
+
+         const std::vector<eosio::name>& accounts() const { return _accounts; }
+         const std::vector<eosio::symbol>& symbols() const { return _symbols; }
+         const eosio::producer_schedule& schedule() const { return _schedule; }
+
+         // fabricates the next block, with `locks` emitxfer receipts of the wraplock contract
+         synthetic_block next(size_t locks);
+         synthetic_block next() { return next(_options.locks_per_block); }
+
+         uint32_t head_block_num() const { return _block_num - 1; }
+
+      private:
+         bridge::actreceipt make_receipt(const eosio::action& act);
+         checksum256 sig_digest(const bridge::blockheader& header) const;
+
+         chain_options                          _options;
+         fixtures::rng                          _rng;
+         checksum256                            _chain_id;
+         incremental_merkle                     _start;
+         std::vector<eosio::name>               _accounts;
+         std::vector<eosio::symbol>             _symbols;
+         eosio::producer_schedule               _schedule;
+         checksum256                            _schedule_hash;
+         std::vector<runtime::k1_private_key>   _keys;                // signing key of each producer of the schedule
+
+         uint32_t                               _block_num;
+         checksum256                            _previous;
+         incremental_merkle                     _blockroot_merkle;    // block merkle before block _block_num
+         uint64_t                               _global_sequence = 1;
+         uint64_t                               _lock_count = 0;
+   };
+
+}
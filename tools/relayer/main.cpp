@@ -0,0 +1,92 @@
+#include <pipeline.hpp>
+#include <runtime.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+   int usage(const char* self) {
+      printf("usage: %s generate <stream> [--blocks <n>] [--locks <per block>] [--anchor-every <blocks>] [--missing-every <locks>] [--seed <n>]\n", self);
+      printf("       %s run <stream> <submissions> [--accounts <file>] [--anchor-wait <blocks>] [--batch <n>] [--queue <n>]\n", self);
+      printf("       %*s [--threads <n>] [--rate <blocks/s>]\n", int(strlen(self) + 4), "");
+      return 1;
+   }
+
+   template <typename T>
+   T percentile(std::vector<T> values, double p) {
+      if (values.empty()) return T();
+      const size_t i = std::min(values.size() - 1, size_t(p * values.size()));
+      std::nth_element(values.begin(), values.begin() + i, values.end());
+      return values[i];
+   }
+
+   int generate(int argc, char** argv) {
+      const std::string path = argv[2];
+      proofs::chain_options options;
+      uint32_t blocks = 4000;
+      uint32_t anchor_every = 240;
+      for (int i = 3; i < argc; i++) {
+         if (!strcmp(argv[i], "--blocks") && i + 1 < argc) blocks = uint32_t(strtoul(argv[++i], nullptr, 10));
+         else if (!strcmp(argv[i], "--locks") && i + 1 < argc) options.locks_per_block = strtoull(argv[++i], nullptr, 10);
+         else if (!strcmp(argv[i], "--anchor-every") && i + 1 < argc) anchor_every = uint32_t(strtoul(argv[++i], nullptr, 10));
+         else if (!strcmp(argv[i], "--missing-every") && i + 1 < argc) options.missing_every = uint32_t(strtoul(argv[++i], nullptr, 10));
+         else if (!strcmp(argv[i], "--seed") && i + 1 < argc) options.seed = strtoull(argv[++i], nullptr, 10);
+         else return usage(argv[0]);
+      }
+
+      relayer::generate(path, path + ".accounts", options, blocks, anchor_every);
+      printf("wrote %u blocks to %s and the lock accounts to %s.accounts\n", blocks, path.c_str(), path.c_str());
+      return 0;
+   }
+
+   int run(int argc, char** argv) {
+      const std::string stream_path = argv[2];
+      const std::string submissions_path = argv[3];
+      std::string accounts_path;
+
+      relayer::config cfg;
+      cfg.store_prefix = submissions_path + ".merkle";
+      for (int i = 4; i < argc; i++) {
+         if (!strcmp(argv[i], "--accounts") && i + 1 < argc) accounts_path = argv[++i];
+         else if (!strcmp(argv[i], "--anchor-wait") && i + 1 < argc) cfg.anchor_wait = uint32_t(strtoul(argv[++i], nullptr, 10));
+         else if (!strcmp(argv[i], "--batch") && i + 1 < argc) cfg.batch_max = std::max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+         else if (!strcmp(argv[i], "--queue") && i + 1 < argc) cfg.queue_capacity = strtoull(argv[++i], nullptr, 10);
+         else if (!strcmp(argv[i], "--threads") && i + 1 < argc) cfg.proof_threads = strtoull(argv[++i], nullptr, 10);
+         else if (!strcmp(argv[i], "--rate") && i + 1 < argc) cfg.blocks_per_second = strtod(argv[++i], nullptr);
+         else return usage(argv[0]);
+      }
+
+      relayer::stream_reader source(stream_path);
+      relayer::file_endpoint target(submissions_path, accounts_path);
+
+      const relayer::report rep = relayer::run(cfg, source, target);
+
+      const double seconds = rep.elapsed_ms / 1000;
+      printf("blocks          %llu (%.0f/s), anchors %llu\n", (unsigned long long)rep.blocks, rep.blocks / seconds, (unsigned long long)rep.anchors);
+      printf("locks           %llu: %llu issued, %llu cancelled, %llu unproven at the end of the stream\n", (unsigned long long)rep.locks,
+             (unsigned long long)rep.issued, (unsigned long long)rep.cancelled, (unsigned long long)rep.unproven);
+      printf("transactions    %llu (%llu light, %llu heavy), %llu bytes\n", (unsigned long long)rep.transactions,
+             (unsigned long long)rep.light, (unsigned long long)rep.heavy, (unsigned long long)rep.bytes);
+      printf("throughput      %.0f locks/s over %.1f ms\n", (rep.issued + rep.cancelled) / seconds, rep.elapsed_ms);
+      printf("lock to submit  p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", percentile(rep.latency_ms, 0.5), percentile(rep.latency_ms, 0.99),
+             percentile(rep.latency_ms, 1.0));
+      printf("                p50 %u blocks, p99 %u blocks, max %u blocks\n", percentile(rep.latency_blocks, 0.5), percentile(rep.latency_blocks, 0.99),
+             percentile(rep.latency_blocks, 1.0));
+      printf("queue full      ingest->proof %llu, proof->pack %llu, pack->submit %llu\n", (unsigned long long)rep.full_waits[0],
+             (unsigned long long)rep.full_waits[1], (unsigned long long)rep.full_waits[2]);
+      return 0;
+   }
+
+}
+
+int main(int argc, char** argv) {
+   runtime::install_crypto();
+
+   if (argc >= 3 && !strcmp(argv[1], "generate")) return generate(argc, argv);
+   if (argc >= 4 && !strcmp(argv[1], "run")) return run(argc, argv);
+
+   return usage(argv[0]);
+}
@@ -0,0 +1,294 @@
+#include <pipeline.hpp>
+#include <queue.hpp>
+#include <locks.hpp>
+#include <secp256k1.hpp>
+
+#include <eosio/transaction.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <thread>
+
+namespace relayer {
+
+   using namespace eosio;
+   using clock = std::chrono::steady_clock;
+
+   namespace {
+
+      // a record with the positions of the wraplock emitxfer receipts of its block
+      struct ingested {
+         record                 rec;
+         std::vector<size_t>    wanted;
+         clock::time_point      arrived;
+      };
+
+      // one issue or cancel action to submit, proving locks of a single block
+      struct job {
+         bool                               cancel = false;
+         bool                               light = false;
+         bridge::lightproof                 lp;
+         bridge::heavyproof                 hp;
+         std::vector<bridge::actionproof>   actions;
+         uint32_t                           block_num = 0;
+         uint32_t                           head_block = 0;
+         time_point_sec                     head_time;
+         clock::time_point                  arrived;
+      };
+
+      struct signed_job {
+         std::vector<char>    packed;
+         size_t               locks = 0;
+         bool                 cancel = false;
+         bool                 light = false;
+         uint32_t             waited = 0;
+         clock::time_point    arrived;
+      };
+
+      // locks of a block that still have to be submitted
+      struct lock_block : proofs::lock_block {
+         clock::time_point                  arrived;
+      };
+
+      // keeps the block merkle of the stream and the headers after the oldest pending lock, and turns locks into jobs as soon
+      // as an anchor covers them or enough headers follow them for finality
+      class proof_stage {
+         public:
+            proof_stage(const config& cfg, const stream_info& info, endpoint& target, spsc_queue<job>& out, report& rep)
+               : _cfg(cfg), _info(info), _target(target), _out(out), _rep(rep), _store(cfg.store_prefix, true) {
+               _store.restore(proofs::incremental_merkle(info.active_nodes, info.node_count));
+            }
+
+            void on_anchor(uint64_t node_count) {
+               _rep.anchors++;
+               _anchor = std::max(_anchor, node_count);
+               advance();
+            }
+
+            void on_block(ingested& in) {
+               const bridge::sblockheader& header = in.rec.block.header;
+               const uint32_t block_num = header.header.block_num();
+               check(_store.node_count() == uint64_t(block_num) - 1, "block stream is not contiguous");
+
+               _rep.blocks++;
+               _store.append(header.header.block_id());
+               _head_block = block_num;
+               _head_time = time_point_sec(header.header.timestamp.to_time_point());
+
+               if (_pending.empty() && in.wanted.empty()) _headers.clear();
+               else {
+                  if (_headers.empty()) _headers_first = block_num;
+                  _headers.push_back(header);
+               }
+
+               if (!in.wanted.empty()) add_locks(in, block_num);
+
+               advance();
+            }
+
+            void finish() {
+               for (const lock_block& p : _pending) _rep.unproven += p.issues.size() + p.cancels.size();
+               _pending.clear();
+            }
+
+         private:
+            void add_locks(ingested& in, uint32_t block_num) {
+               std::vector<bridge::actionproof> proven;
+               const checksum256 root = proofs::build_actionproofs(in.rec.block.actions, in.wanted, proven, _cfg.proof_threads);
+               if (root != in.rec.block.header.header.action_mroot) {
+                  fprintf(stderr, "block %u: receipts do not match the action merkle root, skipped\n", block_num);
+                  return;
+               }
+
+               _rep.locks += proven.size();
+
+               lock_block p;
+               static_cast<proofs::lock_block&>(p) = proofs::make_lock_block(in.rec.block.header, proven,
+                                                                            [&](const name& account) { return _target.is_account(account); });
+               p.arrived = in.arrived;
+               _pending.push_back(std::move(p));
+            }
+
+            void advance() {
+               for (lock_block& p : _pending) {
+                  if (!p.issues.empty() && !emit(p, p.issues, false)) break;
+               }
+
+               for (lock_block& p : _pending) {
+                  if (p.cancels.empty()) continue;
+                  if (_head_time.sec_since_epoch() <= p.block_time().sec_since_epoch() + _cfg.cancel_delay) break;
+                  if (!emit(p, p.cancels, true)) break;
+               }
+
+               // blocks are only dropped from the front, headers are kept from the oldest pending block on
+               while (!_pending.empty() && _pending.front().issues.empty() && _pending.front().cancels.empty()) _pending.pop_front();
+
+               if (_pending.empty()) _headers.clear();
+               while (!_headers.empty() && _headers_first < _pending.front().block_num) {
+                  _headers.pop_front();
+                  _headers_first++;
+               }
+            }
+
+            // queues the jobs of `locks` if the block of `p` can be proven, finality of a block implies finality of the earlier ones
+            bool emit(lock_block& p, std::vector<bridge::actionproof>& locks, bool cancel) {
+               job base{ .cancel = cancel, .block_num = p.block_num, .head_block = _head_block, .head_time = _head_time, .arrived = p.arrived };
+
+               // an anchor reported ahead of the stream is only usable once its blocks have been appended
+               if (_anchor >= p.block_num && _anchor <= _store.node_count()) {
+                  base.light = true;
+                  base.lp = proofs::prove_light(_store, _info.chain_id, p.header.header, _anchor);
+               }
+               else {
+                  if (_head_block - p.block_num < _cfg.anchor_wait) return false;
+                  if (!proofs::try_prove_heavy(_store, _info.chain_id, p.header, _headers, _headers_first, _cfg.schedule_size, base.hp)) return false;
+               }
+
+               for (size_t begin = 0; begin < locks.size(); begin += _cfg.batch_max) {
+                  job j = base;
+                  const size_t end = std::min(locks.size(), begin + _cfg.batch_max);
+                  j.actions.assign(std::make_move_iterator(locks.begin() + begin), std::make_move_iterator(locks.begin() + end));
+                  _out.push(std::move(j));
+               }
+               locks.clear();
+               return true;
+            }
+
+            const config&                       _cfg;
+            const stream_info&                  _info;
+            endpoint&                           _target;
+            spsc_queue<job>&                    _out;
+            report&                             _rep;
+
+            proofs::block_accumulator           _store;
+            uint64_t                            _anchor = 0;
+            uint32_t                            _head_block = 0;
+            time_point_sec                      _head_time;
+            std::deque<lock_block>              _pending;
+            std::deque<bridge::sblockheader>    _headers;
+            uint32_t                            _headers_first = 0;
+      };
+
+      name action_name(const job& j) {
+         const bool batch = j.actions.size() > 1;
+         if (j.cancel) return j.light ? (batch ? "cancelbatchb"_n : "cancelb"_n) : (batch ? "cancelbatcha"_n : "cancela"_n);
+         return j.light ? (batch ? "issuebatchb"_n : "issueb"_n) : (batch ? "issuebatcha"_n : "issuea"_n);
+      }
+
+      template <typename Proof>
+      std::vector<char> action_data(const name& prover, const Proof& proof, const std::vector<bridge::actionproof>& actions) {
+         if (actions.size() == 1) return pack(std::make_tuple(prover, proof, actions[0]));
+         return pack(std::make_tuple(prover, proof, actions));
+      }
+
+      signed_job sign(const config& cfg, const job& j) {
+         action act;
+         act.account = cfg.contract;
+         act.name = action_name(j);
+         act.authorization.push_back(permission_level{ cfg.prover, "active"_n });
+         act.data = j.light ? action_data(cfg.prover, j.lp, j.actions) : action_data(cfg.prover, j.hp, j.actions);
+
+         transaction trx(j.head_time + cfg.expiration);
+         trx.actions.push_back(std::move(act));
+
+         packed_transaction ptrx;
+         ptrx.packed_trx = pack(trx);
+
+         // signing digest over the chain id, the transaction and the empty context free data digest
+         std::vector<char> signed_data(32 + ptrx.packed_trx.size() + 32, 0);
+         const std::array<uint8_t, 32> chain = cfg.chain_id.extract_as_byte_array();
+         memcpy(signed_data.data(), chain.data(), chain.size());
+         memcpy(signed_data.data() + 32, ptrx.packed_trx.data(), ptrx.packed_trx.size());
+         const std::array<uint8_t, 32> digest = sha256(signed_data.data(), signed_data.size()).extract_as_byte_array();
+
+         // signed with the test key of the prover, derived from its name as the synthetic chains derive producer keys
+         const std::string seed = cfg.prover.to_string();
+         const runtime::k1_signature k1 = runtime::k1_sign(runtime::k1_test_key(seed.data(), seed.size()), digest);
+         ecc_signature sig;
+         memcpy(sig.data(), k1.data(), k1.size());
+         ptrx.signatures.push_back(signature(std::in_place_index<0>, sig));
+
+         return signed_job{ .packed = pack(ptrx), .locks = j.actions.size(), .cancel = j.cancel, .light = j.light,
+                            .waited = j.head_block - j.block_num, .arrived = j.arrived };
+      }
+
+   }
+
+   report run(const config& cfg, block_source& source, endpoint& target) {
+      report rep;
+
+      spsc_queue<ingested> blocks(cfg.queue_capacity);
+      spsc_queue<job> jobs(cfg.queue_capacity);
+      spsc_queue<signed_job> signed_jobs(cfg.queue_capacity);
+
+      const name wraplock = source.info().wraplock_contract;
+      const clock::time_point start = clock::now();
+
+      std::thread ingest([&]() {
+         ingested in;
+         for (uint64_t n = 0; source.next(in.rec); n++) {
+            if (cfg.blocks_per_second > 0) {
+               std::this_thread::sleep_until(start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(n / cfg.blocks_per_second)));
+            }
+
+            in.wanted.clear();
+            if (in.rec.kind == record::block) {
+               const auto& actions = in.rec.block.actions;
+               for (size_t i = 0; i < actions.size(); i++) {
+                  if (actions[i].action.account == wraplock && actions[i].action.name == "emitxfer"_n && actions[i].receipt.receiver == wraplock) in.wanted.push_back(i);
+               }
+            }
+            in.arrived = clock::now();
+            blocks.push(std::move(in));
+         }
+         blocks.close();
+      });
+
+      std::thread prove([&]() {
+         proof_stage stage(cfg, source.info(), target, jobs, rep);
+         ingested in;
+         while (blocks.pop(in)) {
+            if (in.rec.kind == record::anchor) stage.on_anchor(in.rec.anchor);
+            else stage.on_block(in);
+         }
+         stage.finish();
+         jobs.close();
+      });
+
+      std::thread pack_stage([&]() {
+         job j;
+         while (jobs.pop(j)) signed_jobs.push(sign(cfg, j));
+         signed_jobs.close();
+      });
+
+      // submission stays on the calling thread
+      signed_job s;
+      while (signed_jobs.pop(s)) {
+         target.submit(s.packed);
+
+         const double latency = std::chrono::duration<double, std::milli>(clock::now() - s.arrived).count();
+         rep.transactions++;
+         rep.bytes += s.packed.size();
+         (s.light ? rep.light : rep.heavy)++;
+         if (s.cancel) rep.cancelled += s.locks;
+         else {
+            rep.issued += s.locks;
+            rep.latency_ms.insert(rep.latency_ms.end(), s.locks, latency);
+            rep.latency_blocks.insert(rep.latency_blocks.end(), s.locks, s.waited);
+         }
+      }
+
+      ingest.join();
+      prove.join();
+      pack_stage.join();
+
+      rep.elapsed_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+      rep.full_waits[0] = blocks.full_waits();
+      rep.full_waits[1] = jobs.full_waits();
+      rep.full_waits[2] = signed_jobs.full_waits();
+      return rep;
+   }
+
+}
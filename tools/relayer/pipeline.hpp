@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stream.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// reference relayer: watches the native chain block stream for emitxfer actions of the wraplock contract and submits the issue
+// and cancel transactions proving them to the wraptoken contract
+namespace relayer {
+
+   // packed transaction as pushed to a node
+   struct packed_transaction {
+      std::vector<eosio::signature>   signatures;
+      uint8_t                         compression = 0;
+      std::vector<char>               packed_context_free_data;
+      std::vector<char>               packed_trx;
+
+      EOSLIB_SERIALIZE( packed_transaction, (signatures)(compression)(packed_context_free_data)(packed_trx) )
+   };
+
+   struct config {
+      name          contract = "wraptoken"_n;
+      name          prover = "relayer"_n;
+      checksum256   chain_id;                    // chain running the wraptoken contract, part of the signing digest
+      size_t        schedule_size = 21;          // producers of the native chain, sets how many headers a heavy proof needs
+      uint32_t      anchor_wait = 0;             // blocks a lock waits for an anchor to cover it before a heavy proof is built
+      uint32_t      cancel_delay = 900;          // seconds after the lock before the contract accepts a cancel
+      uint32_t      expiration = 60;             // seconds after the head block time the transactions expire
+      size_t        batch_max = 8;               // action proofs in one batch action
+      size_t        queue_capacity = 256;        // entries in each queue between stages
+      size_t        proof_threads = 1;           // threads hashing the action merkle tree of a block, 0 for one per hardware thread
+      double        blocks_per_second = 0;       // pace of the ingest stage, 0 reads the stream as fast as possible
+      std::string   store_prefix;                // files of the on-disk block merkle
+   };
+
+   struct report {
+      uint64_t                blocks = 0;
+      uint64_t                anchors = 0;
+      uint64_t                locks = 0;
+      uint64_t                issued = 0;               // locks submitted in issue actions
+      uint64_t                cancelled = 0;            // locks submitted in cancel actions
+      uint64_t                unproven = 0;             // locks still waiting for a proof or the cancel delay at the end of the stream
+      uint64_t                transactions = 0;
+      uint64_t                light = 0;                // transactions with a light block proof
+      uint64_t                heavy = 0;                // transactions with a heavy block proof
+      uint64_t                bytes = 0;
+      double                  elapsed_ms = 0;
+      std::vector<double>     latency_ms;               // ingest of the block to submission, per issued lock
+      std::vector<uint32_t>   latency_blocks;           // blocks streamed after the lock block before submission, per issued lock
+      uint64_t                full_waits[3] = {};       // producer waits on each queue, ingest->proof, proof->pack, pack->submit
+   };
+
+   // runs the ingest, proof, pack and submit stages on one thread each until the end of the stream
+   report run(const config& cfg, block_source& source, endpoint& target);
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace relayer {
+
+   // bounded single producer, single consumer ring connecting two pipeline stages. Each stage runs on its own thread, so the
+   // indices only need acquire/release ordering and no lock is ever taken. A full or empty ring is waited on by yielding.
+   template <typename T>
+   class spsc_queue {
+      public:
+         // `capacity` is rounded up to a power of two
+         explicit spsc_queue(size_t capacity) {
+            size_t size = 2;
+            while (size < capacity) size <<= 1;
+            _mask = size - 1;
+            _slots = std::make_unique<T[]>(size);
+         }
+
+         spsc_queue(const spsc_queue&) = delete;
+         spsc_queue& operator=(const spsc_queue&) = delete;
+
+         // moves from `value` only when it is queued
+         bool try_push(T& value) {
+            const size_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _head_cache > _mask) {
+               _head_cache = _head.load(std::memory_order_acquire);
+               if (tail - _head_cache > _mask) return false;
+            }
+            _slots[tail & _mask] = std::move(value);
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+         }
+
+         bool try_pop(T& value) {
+            const size_t head = _head.load(std::memory_order_relaxed);
+            if (head == _tail_cache) {
+               _tail_cache = _tail.load(std::memory_order_acquire);
+               if (head == _tail_cache) return false;
+            }
+            value = std::move(_slots[head & _mask]);
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+         }
+
+         void push(T value) {
+            while (!try_push(value)) {
+               _full_waits.fetch_add(1, std::memory_order_relaxed);
+               std::this_thread::yield();
+            }
+         }
+
+         // waits for a value, returns false once the queue is closed and drained
+         bool pop(T& value) {
+            while (!try_pop(value)) {
+               if (_closed.load(std::memory_order_acquire)) return try_pop(value);
+               std::this_thread::yield();
+            }
+            return true;
+         }
+
+         // called by the producer after its last push
+         void close() { _closed.store(true, std::memory_order_release); }
+
+         // number of times the producer found the queue full, a stage slower than the one feeding it shows up here
+         uint64_t full_waits() const { return _full_waits.load(std::memory_order_relaxed); }
+
+      private:
+         std::unique_ptr<T[]>          _slots;
+         size_t                        _mask = 0;
+
+         // producer and consumer indices on separate cache lines, each with the side's last view of the other index
+         alignas(64) std::atomic<size_t>   _tail{ 0 };
+         size_t                            _head_cache = 0;
+         alignas(64) std::atomic<size_t>   _head{ 0 };
+         size_t                            _tail_cache = 0;
+
+         alignas(64) std::atomic<bool>     _closed{ false };
+         std::atomic<uint64_t>             _full_waits{ 0 };
+   };
+
+}
@@ -0,0 +1,140 @@
+#include <stream.hpp>
+
+#include <cstring>
+
+namespace relayer {
+
+   using namespace eosio;
+
+   namespace {
+
+      const uint32_t STREAM_MAGIC = 0x53525457;   // "WTRS"
+
+      bool read_exact(FILE* f, void* data, size_t size) {
+         return size == 0 || fread(data, size, 1, f) == 1;
+      }
+
+      void write_exact(FILE* f, const void* data, size_t size) {
+         check(size == 0 || fwrite(data, size, 1, f) == 1, "write to stream file failed");
+      }
+
+   }
+
+   stream_reader::stream_reader(const std::string& path) {
+      _file = fopen(path.c_str(), "rb");
+      check(_file != nullptr, "block stream does not exist");
+
+      uint32_t magic = 0, size = 0;
+      check(read_exact(_file, &magic, sizeof(magic)) && magic == STREAM_MAGIC, "not a block stream");
+      check(read_exact(_file, &size, sizeof(size)), "block stream is truncated");
+
+      _buffer.resize(size);
+      check(read_exact(_file, _buffer.data(), size), "block stream is truncated");
+      _info = unpack<stream_info>(_buffer);
+   }
+
+   stream_reader::~stream_reader() {
+      if (_file) fclose(_file);
+   }
+
+   bool stream_reader::next(record& r) {
+      uint8_t kind = 0;
+      uint32_t size = 0;
+      if (!read_exact(_file, &kind, sizeof(kind))) return false;
+      check(read_exact(_file, &size, sizeof(size)), "block stream is truncated");
+
+      _buffer.resize(size);
+      check(read_exact(_file, _buffer.data(), size), "block stream is truncated");
+
+      r.kind = kind;
+      if (kind == record::block) r.block = unpack<stream_block>(_buffer);
+      else if (kind == record::anchor) r.anchor = unpack<uint64_t>(_buffer);
+      else check(false, "unknown block stream record");
+      return true;
+   }
+
+   stream_writer::stream_writer(const std::string& path, const stream_info& info) {
+      _file = fopen(path.c_str(), "wb");
+      check(_file != nullptr, "cannot create block stream");
+
+      const std::vector<char> packed = pack(info);
+      const uint32_t size = uint32_t(packed.size());
+      write_exact(_file, &STREAM_MAGIC, sizeof(STREAM_MAGIC));
+      write_exact(_file, &size, sizeof(size));
+      write_exact(_file, packed.data(), packed.size());
+   }
+
+   stream_writer::~stream_writer() {
+      if (_file) fclose(_file);
+   }
+
+   void stream_writer::write_block(const stream_block& block) {
+      write(record::block, pack(block));
+   }
+
+   void stream_writer::write_anchor(uint64_t node_count) {
+      write(record::anchor, pack(node_count));
+   }
+
+   void stream_writer::write(uint8_t kind, const std::vector<char>& payload) {
+      const uint32_t size = uint32_t(payload.size());
+      write_exact(_file, &kind, sizeof(kind));
+      write_exact(_file, &size, sizeof(size));
+      write_exact(_file, payload.data(), payload.size());
+   }
+
+   file_endpoint::file_endpoint(const std::string& path, const std::string& accounts_path) {
+      _file = fopen(path.c_str(), "wb");
+      check(_file != nullptr, "cannot create submission file");
+
+      if (accounts_path.empty()) return;
+
+      FILE* f = fopen(accounts_path.c_str(), "r");
+      check(f != nullptr, "accounts file does not exist");
+      char line[64];
+      while (fgets(line, sizeof(line), f)) {
+         line[strcspn(line, "\r\n")] = 0;
+         if (line[0]) _accounts.insert(name(line).value);
+      }
+      fclose(f);
+      _all_accounts = false;
+   }
+
+   file_endpoint::~file_endpoint() {
+      if (_file) fclose(_file);
+   }
+
+   bool file_endpoint::is_account(const name& account) const {
+      return _all_accounts || _accounts.count(account.value) > 0;
+   }
+
+   void file_endpoint::submit(const std::vector<char>& packed) {
+      const uint32_t size = uint32_t(packed.size());
+      write_exact(_file, &size, sizeof(size));
+      write_exact(_file, packed.data(), packed.size());
+   }
+
+   void generate(const std::string& path, const std::string& accounts_path, const proofs::chain_options& options, uint32_t blocks, uint32_t anchor_every) {
+      proofs::synthetic_chain chain(options);
+
+      stream_info info;
+      info.chain_id = chain.chain_id();
+      info.wraplock_contract = chain.wraplock_contract();
+      info.active_nodes = chain.start().active_nodes();
+      info.node_count = chain.start().node_count();
+
+      FILE* f = fopen(accounts_path.c_str(), "w");
+      check(f != nullptr, "cannot create accounts file");
+      for (name a : chain.accounts()) fprintf(f, "%s\n", a.to_string().c_str());
+      fclose(f);
+
+      stream_writer out(path, info);
+
+      for (uint32_t i = 1; i <= blocks; i++) {
+         proofs::synthetic_block b = chain.next();
+         out.write_block(stream_block{ .header = std::move(b.header), .actions = std::move(b.actions) });
+         if (anchor_every && i % anchor_every == 0) out.write_anchor(chain.head_block_num());
+      }
+   }
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <builder.hpp>
+#include <synthetic.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+// inputs and outputs of the relayer: the native chain block stream it watches and the endpoint it submits transactions to, with
+// file backed stand-ins for both so the relayer runs end to end without a network
+namespace relayer {
+
+   using eosio::checksum256;
+   using eosio::name;
+
+   // a native chain block: its signed header and its action receipts in action merkle order
+   struct stream_block {
+      bridge::sblockheader                header;
+      std::vector<proofs::block_action>   actions;
+
+      EOSLIB_SERIALIZE( stream_block, (header)(actions) )
+   };
+
+   // one entry of the block stream, either a block or the bridge reporting that it holds the block merkle root over the first
+   // `anchor` block ids, which light proofs of the blocks it covers can be checked against
+   struct record {
+      enum kind_t : uint8_t { block = 1, anchor = 2 };
+
+      uint8_t        kind = 0;
+      stream_block   block;
+      uint64_t       anchor = 0;
+   };
+
+   // what the relayer needs to know about the native chain before the first block of a stream
+   struct stream_info {
+      checksum256                 chain_id;
+      name                        wraplock_contract;
+      std::vector<checksum256>    active_nodes;     // block merkle before the first block of the stream
+      uint64_t                    node_count = 0;
+
+      EOSLIB_SERIALIZE( stream_info, (chain_id)(wraplock_contract)(active_nodes)(node_count) )
+   };
+
+   class block_source {
+      public:
+         virtual ~block_source() = default;
+
+         virtual const stream_info& info() const = 0;
+
+         // blocks are delivered in block number order without gaps, returns false at the end of the stream
+         virtual bool next(record& r) = 0;
+   };
+
+   class endpoint {
+      public:
+         virtual ~endpoint() = default;
+
+         // called from the proof stage to route locks to an account that cannot receive tokens to a cancel
+         virtual bool is_account(const name& account) const = 0;
+
+         // called from the submit stage with a packed transaction as pushed to a node
+         virtual void submit(const std::vector<char>& packed) = 0;
+   };
+
+   // block stream file: a magic, the packed stream_info, then each record as a kind byte, a length and the packed block or anchor
+   class stream_reader : public block_source {
+      public:
+         explicit stream_reader(const std::string& path);
+         ~stream_reader();
+
+         stream_reader(const stream_reader&) = delete;
+         stream_reader& operator=(const stream_reader&) = delete;
+
+         const stream_info& info() const override { return _info; }
+         bool next(record& r) override;
+
+      private:
+         FILE*                _file = nullptr;
+         stream_info          _info;
+         std::vector<char>    _buffer;
+   };
+
+   class stream_writer {
+      public:
+         stream_writer(const std::string& path, const stream_info& info);
+         ~stream_writer();
+
+         stream_writer(const stream_writer&) = delete;
+         stream_writer& operator=(const stream_writer&) = delete;
+
+         void write_block(const stream_block& block);
+         void write_anchor(uint64_t node_count);
+
+      private:
+         void write(uint8_t kind, const std::vector<char>& payload);
+
+         FILE* _file = nullptr;
+   };
+
+   // appends every submitted transaction to a file, length prefixed. Accounts are read from a file with one name per line,
+   // every account exists when no file is given.
+   class file_endpoint : public endpoint {
+      public:
+         file_endpoint(const std::string& path, const std::string& accounts_path);
+         ~file_endpoint();
+
+         file_endpoint(const file_endpoint&) = delete;
+         file_endpoint& operator=(const file_endpoint&) = delete;
+
+         bool is_account(const name& account) const override;
+         void submit(const std::vector<char>& packed) override;
+
+      private:
+         FILE*                _file = nullptr;
+         bool                 _all_accounts = true;
+         std::set<uint64_t>   _accounts;
+   };
+
+   // writes `blocks` blocks of a synthetic chain to `path` with an anchor every `anchor_every` blocks, 0 for none, and the accounts
+   // the locks go to to `accounts_path`
+   void generate(const std::string& path, const std::string& accounts_path, const proofs::chain_options& options, uint32_t blocks, uint32_t anchor_every);
+
+}
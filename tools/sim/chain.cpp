@@ -0,0 +1,580 @@
+#include <chain.hpp>
+
+#include <eosio/tester.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+namespace sim {
+
+   namespace {
+      chain* active_chain = nullptr;
+
+      key256 load256(const void* data) {
+         key256 k;
+         memcpy(k.data(), data, sizeof(k));
+         return k;
+      }
+   }
+
+   chain::chain() {
+      _idx64.row_ram = IDX64_RAM;
+      _idx256.row_ram = IDX256_RAM;
+   }
+
+   chain& chain::active() {
+      if (!active_chain) {
+         fprintf(stderr, "no active chain\n");
+         abort();
+      }
+      return *active_chain;
+   }
+
+   void chain::fail(const std::string& message) {
+      if (_guards == 0) {
+         fprintf(stderr, "unhandled assertion: %s\n", message.c_str());
+         abort();
+      }
+      throw assertion_failure{ message };
+   }
+
+   void chain::begin_action(uint64_t receiver, const std::set<uint64_t>& auths) {
+      _receiver = receiver;
+      _auths = auths;
+      _cost = action_cost{};
+      // iterators are only valid within the action that created them
+      _iterators.clear();
+      _idx64.iterators.clear();
+      _idx256.iterators.clear();
+   }
+
+   action_cost chain::end_action() {
+      action_cost cost = std::move(_cost);
+      _cost = action_cost{};
+      return cost;
+   }
+
+   void chain::begin_transaction() {
+      _undo.clear();
+      _in_transaction = true;
+   }
+
+   void chain::commit() {
+      _undo.clear();
+      _in_transaction = false;
+   }
+
+   void chain::rollback() {
+      for (auto itr = _undo.rbegin(); itr != _undo.rend(); itr++) itr->restore();
+      _undo.clear();
+      _in_transaction = false;
+   }
+
+   uint64_t chain::row_count(uint64_t code, uint64_t tbl) const {
+      uint64_t count = 0;
+      for (const auto& t : _tables) {
+         if (t.first.code == code && t.first.table == tbl) count += t.second.rows.size();
+      }
+      return count;
+   }
+
+   int64_t chain::ram_usage(uint64_t account) const {
+      auto itr = _ram.find(account);
+      return itr == _ram.end() ? 0 : itr->second;
+   }
+
+   void chain::bill(uint64_t payer, int64_t delta) {
+      if (delta == 0) return;
+      _ram[payer] += delta;
+      _cost.ram[payer] += delta;
+      if (_in_transaction) {
+         _undo.push_back(undo_entry{ [this, payer, delta]() { _ram[payer] -= delta; } });
+      }
+   }
+
+   // primary tables
+
+   chain::table* chain::find_table(uint64_t code, uint64_t scope, uint64_t tbl) {
+      auto itr = _tables.find(table_key{ code, scope, tbl });
+      if (itr == _tables.end() || itr->second.rows.empty()) return nullptr;
+      return &itr->second;
+   }
+
+   chain::table& chain::get_or_create_table(uint64_t scope, uint64_t tbl, uint64_t payer) {
+      table_key key{ _receiver, scope, tbl };
+      auto itr = _tables.find(key);
+      if (itr == _tables.end()) {
+         itr = _tables.emplace(key, table{}).first;
+         itr->second.key = key;
+         itr->second.end_iterator = -2 - int32_t(_by_end.size());
+         _by_end.push_back(&itr->second);
+      }
+      table& t = itr->second;
+      if (t.rows.empty()) {
+         uint64_t previous_payer = t.payer;
+         t.payer = payer;
+         bill(payer, TABLE_RAM);
+         if (_in_transaction) _undo.push_back(undo_entry{ [&t, previous_payer]() { t.payer = previous_payer; } });
+      }
+      return t;
+   }
+
+   int32_t chain::iterator_to(table& t, uint64_t primary) {
+      _iterators.emplace_back(&t, primary);
+      return int32_t(_iterators.size() - 1);
+   }
+
+   chain::table& chain::table_of_end(int32_t end) {
+      size_t ordinal = size_t(-2 - end);
+      if (end >= -1 || ordinal >= _by_end.size()) fail("invalid end iterator");
+      return *_by_end[ordinal];
+   }
+
+   std::pair<chain::table*, uint64_t> chain::row_at(int32_t itr) {
+      if (itr < 0 || size_t(itr) >= _iterators.size()) fail("invalid iterator");
+      auto entry = _iterators[size_t(itr)];
+      if (!entry.first->rows.count(entry.second)) fail("dereference of deleted object");
+      return entry;
+   }
+
+   int32_t chain::db_store(uint64_t scope, uint64_t tbl, uint64_t payer, uint64_t id, const void* data, uint32_t len) {
+      _cost.writes++;
+      table& t = get_or_create_table(scope, tbl, payer);
+      if (t.rows.count(id)) fail("key uniqueness violation");
+      t.rows[id] = row{ payer, std::vector<char>((const char*)data, (const char*)data + len) };
+      bill(payer, int64_t(len) + ROW_RAM);
+      if (_in_transaction) _undo.push_back(undo_entry{ [&t, id]() { t.rows.erase(id); } });
+      return iterator_to(t, id);
+   }
+
+   void chain::db_update(int32_t itr, uint64_t payer, const void* data, uint32_t len) {
+      _cost.writes++;
+      auto [t, primary] = row_at(itr);
+      row& r = t->rows[primary];
+      if (payer == 0) payer = r.payer;
+      row previous = r;
+      bill(r.payer, -(int64_t(r.data.size()) + ROW_RAM));
+      bill(payer, int64_t(len) + ROW_RAM);
+      r = row{ payer, std::vector<char>((const char*)data, (const char*)data + len) };
+      if (_in_transaction) _undo.push_back(undo_entry{ [t = t, primary = primary, previous]() { t->rows[primary] = previous; } });
+   }
+
+   void chain::db_remove(int32_t itr) {
+      _cost.writes++;
+      auto [t, primary] = row_at(itr);
+      row previous = t->rows[primary];
+      bill(previous.payer, -(int64_t(previous.data.size()) + ROW_RAM));
+      t->rows.erase(primary);
+      if (t->rows.empty()) bill(t->payer, -TABLE_RAM);
+      if (_in_transaction) _undo.push_back(undo_entry{ [t = t, primary = primary, previous]() { t->rows[primary] = previous; } });
+   }
+
+   int32_t chain::db_get(int32_t itr, void* data, uint32_t len) {
+      _cost.reads++;
+      auto [t, primary] = row_at(itr);
+      const std::vector<char>& bytes = t->rows[primary].data;
+      if (len == 0) return int32_t(bytes.size());
+      uint32_t copy = std::min<uint32_t>(len, uint32_t(bytes.size()));
+      memcpy(data, bytes.data(), copy);
+      return int32_t(copy);
+   }
+
+   int32_t chain::db_next(int32_t itr, uint64_t* primary) {
+      _cost.reads++;
+      if (itr < -1) return -1;
+      auto [t, pk] = row_at(itr);
+      auto next = t->rows.upper_bound(pk);
+      if (next == t->rows.end()) return t->end_iterator;
+      *primary = next->first;
+      return iterator_to(*t, next->first);
+   }
+
+   int32_t chain::db_previous(int32_t itr, uint64_t* primary) {
+      _cost.reads++;
+      table* t;
+      std::map<uint64_t, row>::iterator prev;
+      if (itr < -1) {
+         t = &table_of_end(itr);
+         if (t->rows.empty()) return -1;
+         prev = std::prev(t->rows.end());
+      } else {
+         auto [tp, pk] = row_at(itr);
+         t = tp;
+         auto current = t->rows.find(pk);
+         if (current == t->rows.begin()) return -1;
+         prev = std::prev(current);
+      }
+      *primary = prev->first;
+      return iterator_to(*t, prev->first);
+   }
+
+   int32_t chain::db_find(uint64_t code, uint64_t scope, uint64_t tbl, uint64_t id) {
+      _cost.reads++;
+      table* t = find_table(code, scope, tbl);
+      if (!t) return -1;
+      if (!t->rows.count(id)) return t->end_iterator;
+      return iterator_to(*t, id);
+   }
+
+   int32_t chain::db_lowerbound(uint64_t code, uint64_t scope, uint64_t tbl, uint64_t id) {
+      _cost.reads++;
+      table* t = find_table(code, scope, tbl);
+      if (!t) return -1;
+      auto itr = t->rows.lower_bound(id);
+      if (itr == t->rows.end()) return t->end_iterator;
+      return iterator_to(*t, itr->first);
+   }
+
+   int32_t chain::db_upperbound(uint64_t code, uint64_t scope, uint64_t tbl, uint64_t id) {
+      _cost.reads++;
+      table* t = find_table(code, scope, tbl);
+      if (!t) return -1;
+      auto itr = t->rows.upper_bound(id);
+      if (itr == t->rows.end()) return t->end_iterator;
+      return iterator_to(*t, itr->first);
+   }
+
+   int32_t chain::db_end(uint64_t code, uint64_t scope, uint64_t tbl) {
+      _cost.reads++;
+      table* t = find_table(code, scope, tbl);
+      return t ? t->end_iterator : -1;
+   }
+
+   // secondary indexes
+
+   template <typename K>
+   chain::index<K>* chain::find_index(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl) {
+      auto itr = set.indexes.find(table_key{ code, scope, tbl });
+      if (itr == set.indexes.end() || itr->second.entries.empty()) return nullptr;
+      return &itr->second;
+   }
+
+   template <typename K>
+   chain::index<K>& chain::get_or_create_index(index_set<K>& set, uint64_t scope, uint64_t tbl, uint64_t payer) {
+      table_key key{ _receiver, scope, tbl };
+      auto itr = set.indexes.find(key);
+      if (itr == set.indexes.end()) {
+         itr = set.indexes.emplace(key, index<K>{}).first;
+         itr->second.key = key;
+         itr->second.end_iterator = -2 - int32_t(set.by_end.size());
+         set.by_end.push_back(&itr->second);
+      }
+      index<K>& idx = itr->second;
+      if (idx.entries.empty()) {
+         uint64_t previous_payer = idx.payer;
+         idx.payer = payer;
+         bill(payer, TABLE_RAM);
+         if (_in_transaction) _undo.push_back(undo_entry{ [&idx, previous_payer]() { idx.payer = previous_payer; } });
+      }
+      return idx;
+   }
+
+   template <typename K>
+   int32_t chain::index_iterator(index_set<K>& set, index<K>& idx, uint64_t primary) {
+      set.iterators.emplace_back(&idx, primary);
+      return int32_t(set.iterators.size() - 1);
+   }
+
+   template <typename K>
+   std::pair<chain::index<K>*, uint64_t> chain::index_entry(index_set<K>& set, int32_t itr) {
+      if (itr < 0 || size_t(itr) >= set.iterators.size()) fail("invalid secondary iterator");
+      auto entry = set.iterators[size_t(itr)];
+      if (!entry.first->by_primary.count(entry.second)) fail("dereference of deleted secondary object");
+      return entry;
+   }
+
+   template <typename K>
+   int32_t chain::idx_store(index_set<K>& set, uint64_t scope, uint64_t tbl, uint64_t payer, uint64_t id, const K& secondary) {
+      _cost.secondary_writes++;
+      index<K>& idx = get_or_create_index(set, scope, tbl, payer);
+      idx.entries.emplace(secondary, id);
+      idx.by_primary[id] = std::make_pair(secondary, payer);
+      bill(payer, set.row_ram);
+      if (_in_transaction) {
+         _undo.push_back(undo_entry{ [&idx, id, secondary]() {
+            idx.entries.erase(std::make_pair(secondary, id));
+            idx.by_primary.erase(id);
+         } });
+      }
+      return index_iterator(set, idx, id);
+   }
+
+   template <typename K>
+   void chain::idx_update(index_set<K>& set, int32_t itr, uint64_t payer, const K& secondary) {
+      _cost.secondary_writes++;
+      auto [idx, primary] = index_entry(set, itr);
+      auto previous = idx->by_primary[primary];
+      if (payer == 0) payer = previous.second;
+      bill(previous.second, -set.row_ram);
+      bill(payer, set.row_ram);
+      idx->entries.erase(std::make_pair(previous.first, primary));
+      idx->entries.emplace(secondary, primary);
+      idx->by_primary[primary] = std::make_pair(secondary, payer);
+      if (_in_transaction) {
+         _undo.push_back(undo_entry{ [idx = idx, primary = primary, previous, secondary]() {
+            idx->entries.erase(std::make_pair(secondary, primary));
+            idx->entries.emplace(previous.first, primary);
+            idx->by_primary[primary] = previous;
+         } });
+      }
+   }
+
+   template <typename K>
+   void chain::idx_remove(index_set<K>& set, int32_t itr) {
+      _cost.secondary_writes++;
+      auto [idx, primary] = index_entry(set, itr);
+      auto previous = idx->by_primary[primary];
+      bill(previous.second, -set.row_ram);
+      idx->entries.erase(std::make_pair(previous.first, primary));
+      idx->by_primary.erase(primary);
+      if (idx->entries.empty()) bill(idx->payer, -TABLE_RAM);
+      if (_in_transaction) {
+         _undo.push_back(undo_entry{ [idx = idx, primary = primary, previous]() {
+            idx->entries.emplace(previous.first, primary);
+            idx->by_primary[primary] = previous;
+         } });
+      }
+   }
+
+   template <typename K>
+   int32_t chain::idx_next(index_set<K>& set, int32_t itr, uint64_t* primary) {
+      _cost.secondary_reads++;
+      if (itr < -1) return -1;
+      auto [idx, pk] = index_entry(set, itr);
+      auto next = idx->entries.upper_bound(std::make_pair(idx->by_primary[pk].first, pk));
+      if (next == idx->entries.end()) return idx->end_iterator;
+      *primary = next->second;
+      return index_iterator(set, *idx, next->second);
+   }
+
+   template <typename K>
+   int32_t chain::idx_previous(index_set<K>& set, int32_t itr, uint64_t* primary) {
+      _cost.secondary_reads++;
+      index<K>* idx;
+      typename std::set<std::pair<K, uint64_t>>::iterator prev;
+      if (itr < -1) {
+         size_t ordinal = size_t(-2 - itr);
+         if (ordinal >= set.by_end.size()) fail("invalid secondary end iterator");
+         idx = set.by_end[ordinal];
+         if (idx->entries.empty()) return -1;
+         prev = std::prev(idx->entries.end());
+      } else {
+         auto [ip, pk] = index_entry(set, itr);
+         idx = ip;
+         auto current = idx->entries.find(std::make_pair(idx->by_primary[pk].first, pk));
+         if (current == idx->entries.begin()) return -1;
+         prev = std::prev(current);
+      }
+      *primary = prev->second;
+      return index_iterator(set, *idx, prev->second);
+   }
+
+   template <typename K>
+   int32_t chain::idx_find_primary(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl, K& secondary, uint64_t primary) {
+      _cost.secondary_reads++;
+      index<K>* idx = find_index(set, code, scope, tbl);
+      if (!idx) return -1;
+      auto itr = idx->by_primary.find(primary);
+      if (itr == idx->by_primary.end()) return idx->end_iterator;
+      secondary = itr->second.first;
+      return index_iterator(set, *idx, primary);
+   }
+
+   template <typename K>
+   int32_t chain::idx_find_secondary(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl, const K& secondary, uint64_t* primary) {
+      _cost.secondary_reads++;
+      index<K>* idx = find_index(set, code, scope, tbl);
+      if (!idx) return -1;
+      auto itr = idx->entries.lower_bound(std::make_pair(secondary, uint64_t(0)));
+      if (itr == idx->entries.end() || itr->first != secondary) return idx->end_iterator;
+      *primary = itr->second;
+      return index_iterator(set, *idx, itr->second);
+   }
+
+   template <typename K>
+   int32_t chain::idx_lowerbound(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl, K& secondary, uint64_t* primary) {
+      _cost.secondary_reads++;
+      index<K>* idx = find_index(set, code, scope, tbl);
+      if (!idx) return -1;
+      auto itr = idx->entries.lower_bound(std::make_pair(secondary, uint64_t(0)));
+      if (itr == idx->entries.end()) return idx->end_iterator;
+      secondary = itr->first;
+      *primary = itr->second;
+      return index_iterator(set, *idx, itr->second);
+   }
+
+   template <typename K>
+   int32_t chain::idx_upperbound(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl, K& secondary, uint64_t* primary) {
+      _cost.secondary_reads++;
+      index<K>* idx = find_index(set, code, scope, tbl);
+      if (!idx) return -1;
+      auto itr = idx->entries.upper_bound(std::make_pair(secondary, std::numeric_limits<uint64_t>::max()));
+      if (itr == idx->entries.end()) return idx->end_iterator;
+      secondary = itr->first;
+      *primary = itr->second;
+      return index_iterator(set, *idx, itr->second);
+   }
+
+   template <typename K>
+   int32_t chain::idx_end(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl) {
+      _cost.secondary_reads++;
+      index<K>* idx = find_index(set, code, scope, tbl);
+      return idx ? idx->end_iterator : -1;
+   }
+
+   void chain::activate() {
+      using namespace eosio::native;
+      active_chain = this;
+
+      // assertions unwind to the innermost guarded() call
+      intrinsics::set_intrinsic<intrinsics::eosio_assert>([](uint32_t test, const char* msg) {
+         if (!test) chain::active().fail(msg);
+      });
+      intrinsics::set_intrinsic<intrinsics::eosio_assert_message>([](uint32_t test, const char* msg, uint32_t len) {
+         if (!test) chain::active().fail(std::string(msg, len));
+      });
+      intrinsics::set_intrinsic<intrinsics::eosio_assert_code>([](uint32_t test, uint64_t code) {
+         if (!test) chain::active().fail("assertion failure with error code: " + std::to_string(code));
+      });
+
+      intrinsics::set_intrinsic<intrinsics::current_time>([]() { return chain::active()._now; });
+      intrinsics::set_intrinsic<intrinsics::current_receiver>([]() { return chain::active()._receiver; });
+
+      intrinsics::set_intrinsic<intrinsics::is_account>([](uint64_t account) { return chain::active().is_account(account); });
+      intrinsics::set_intrinsic<intrinsics::has_auth>([](uint64_t account) { return chain::active()._auths.count(account) > 0; });
+      intrinsics::set_intrinsic<intrinsics::require_auth>([](uint64_t account) {
+         chain& c = chain::active();
+         if (!c._auths.count(account)) c.fail("missing authority of " + eosio::name(account).to_string());
+      });
+      intrinsics::set_intrinsic<intrinsics::require_auth2>([](uint64_t account, uint64_t) {
+         chain& c = chain::active();
+         if (!c._auths.count(account)) c.fail("missing authority of " + eosio::name(account).to_string());
+      });
+      intrinsics::set_intrinsic<intrinsics::require_recipient>([](uint64_t account) {
+         chain::active()._cost.notified.push_back(account);
+      });
+      intrinsics::set_intrinsic<intrinsics::send_inline>([](auto* serialized, size_t size) {
+         const char* bytes = (const char*)serialized;
+         chain::active()._cost.inline_actions.emplace_back(bytes, bytes + size);
+      });
+
+      intrinsics::set_intrinsic<intrinsics::db_store_i64>([](uint64_t scope, uint64_t tbl, uint64_t payer, uint64_t id, const void* data, uint32_t len) {
+         return chain::active().db_store(scope, tbl, payer, id, data, len);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_update_i64>([](int32_t itr, uint64_t payer, const void* data, uint32_t len) {
+         chain::active().db_update(itr, payer, data, len);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_remove_i64>([](int32_t itr) { chain::active().db_remove(itr); });
+      intrinsics::set_intrinsic<intrinsics::db_get_i64>([](int32_t itr, void* data, uint32_t len) { return chain::active().db_get(itr, data, len); });
+      intrinsics::set_intrinsic<intrinsics::db_next_i64>([](int32_t itr, uint64_t* primary) { return chain::active().db_next(itr, primary); });
+      intrinsics::set_intrinsic<intrinsics::db_previous_i64>([](int32_t itr, uint64_t* primary) { return chain::active().db_previous(itr, primary); });
+      intrinsics::set_intrinsic<intrinsics::db_find_i64>([](uint64_t code, uint64_t scope, uint64_t tbl, uint64_t id) {
+         return chain::active().db_find(code, scope, tbl, id);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_lowerbound_i64>([](uint64_t code, uint64_t scope, uint64_t tbl, uint64_t id) {
+         return chain::active().db_lowerbound(code, scope, tbl, id);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_upperbound_i64>([](uint64_t code, uint64_t scope, uint64_t tbl, uint64_t id) {
+         return chain::active().db_upperbound(code, scope, tbl, id);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_end_i64>([](uint64_t code, uint64_t scope, uint64_t tbl) {
+         return chain::active().db_end(code, scope, tbl);
+      });
+
+      intrinsics::set_intrinsic<intrinsics::db_idx64_store>([](uint64_t scope, uint64_t tbl, uint64_t payer, uint64_t id, const uint64_t* secondary) {
+         chain& c = chain::active();
+         return c.idx_store(c._idx64, scope, tbl, payer, id, *secondary);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx64_update>([](int32_t itr, uint64_t payer, const uint64_t* secondary) {
+         chain& c = chain::active();
+         c.idx_update(c._idx64, itr, payer, *secondary);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx64_remove>([](int32_t itr) {
+         chain& c = chain::active();
+         c.idx_remove(c._idx64, itr);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx64_next>([](int32_t itr, uint64_t* primary) {
+         chain& c = chain::active();
+         return c.idx_next(c._idx64, itr, primary);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx64_previous>([](int32_t itr, uint64_t* primary) {
+         chain& c = chain::active();
+         return c.idx_previous(c._idx64, itr, primary);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx64_find_primary>([](uint64_t code, uint64_t scope, uint64_t tbl, uint64_t* secondary, uint64_t primary) {
+         chain& c = chain::active();
+         return c.idx_find_primary(c._idx64, code, scope, tbl, *secondary, primary);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx64_find_secondary>([](uint64_t code, uint64_t scope, uint64_t tbl, const uint64_t* secondary, uint64_t* primary) {
+         chain& c = chain::active();
+         return c.idx_find_secondary(c._idx64, code, scope, tbl, *secondary, primary);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx64_lowerbound>([](uint64_t code, uint64_t scope, uint64_t tbl, uint64_t* secondary, uint64_t* primary) {
+         chain& c = chain::active();
+         return c.idx_lowerbound(c._idx64, code, scope, tbl, *secondary, primary);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx64_upperbound>([](uint64_t code, uint64_t scope, uint64_t tbl, uint64_t* secondary, uint64_t* primary) {
+         chain& c = chain::active();
+         return c.idx_upperbound(c._idx64, code, scope, tbl, *secondary, primary);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx64_end>([](uint64_t code, uint64_t scope, uint64_t tbl) {
+         chain& c = chain::active();
+         return c.idx_end(c._idx64, code, scope, tbl);
+      });
+
+      // idx256 keys are passed as two 128 bit words
+      intrinsics::set_intrinsic<intrinsics::db_idx256_store>([](uint64_t scope, uint64_t tbl, uint64_t payer, uint64_t id, const auto* data, uint32_t) {
+         chain& c = chain::active();
+         return c.idx_store(c._idx256, scope, tbl, payer, id, load256(data));
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx256_update>([](int32_t itr, uint64_t payer, const auto* data, uint32_t) {
+         chain& c = chain::active();
+         c.idx_update(c._idx256, itr, payer, load256(data));
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx256_remove>([](int32_t itr) {
+         chain& c = chain::active();
+         c.idx_remove(c._idx256, itr);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx256_next>([](int32_t itr, uint64_t* primary) {
+         chain& c = chain::active();
+         return c.idx_next(c._idx256, itr, primary);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx256_previous>([](int32_t itr, uint64_t* primary) {
+         chain& c = chain::active();
+         return c.idx_previous(c._idx256, itr, primary);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx256_find_primary>([](uint64_t code, uint64_t scope, uint64_t tbl, auto* data, uint32_t, uint64_t primary) {
+         chain& c = chain::active();
+         key256 secondary{};
+         int32_t itr = c.idx_find_primary(c._idx256, code, scope, tbl, secondary, primary);
+         memcpy((void*)data, secondary.data(), sizeof(secondary));
+         return itr;
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx256_find_secondary>([](uint64_t code, uint64_t scope, uint64_t tbl, const auto* data, uint32_t, uint64_t* primary) {
+         chain& c = chain::active();
+         return c.idx_find_secondary(c._idx256, code, scope, tbl, load256(data), primary);
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx256_lowerbound>([](uint64_t code, uint64_t scope, uint64_t tbl, auto* data, uint32_t, uint64_t* primary) {
+         chain& c = chain::active();
+         key256 secondary = load256(data);
+         int32_t itr = c.idx_lowerbound(c._idx256, code, scope, tbl, secondary, primary);
+         memcpy((void*)data, secondary.data(), sizeof(secondary));
+         return itr;
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx256_upperbound>([](uint64_t code, uint64_t scope, uint64_t tbl, auto* data, uint32_t, uint64_t* primary) {
+         chain& c = chain::active();
+         key256 secondary = load256(data);
+         int32_t itr = c.idx_upperbound(c._idx256, code, scope, tbl, secondary, primary);
+         memcpy((void*)data, secondary.data(), sizeof(secondary));
+         return itr;
+      });
+      intrinsics::set_intrinsic<intrinsics::db_idx256_end>([](uint64_t code, uint64_t scope, uint64_t tbl) {
+         chain& c = chain::active();
+         return c.idx_end(c._idx256, code, scope, tbl);
+      });
+   }
+
+}
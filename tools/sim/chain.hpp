@@ -0,0 +1,187 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+   // ram billed by nodeos per object on top of the row data (billable_size in chain/config.hpp)
+   constexpr int64_t TABLE_RAM = 108;
+   constexpr int64_t ROW_RAM = 108;
+   constexpr int64_t IDX64_RAM = 128;
+   constexpr int64_t IDX256_RAM = 152;
+
+   using key256 = std::array<unsigned __int128, 2>;
+
+   struct table_key {
+      uint64_t code;
+      uint64_t scope;
+      uint64_t table;
+
+      bool operator<(const table_key& o) const {
+         if (code != o.code) return code < o.code;
+         if (scope != o.scope) return scope < o.scope;
+         return table < o.table;
+      }
+   };
+
+   // db intrinsic calls, ram and side effects of one action
+   struct action_cost {
+      uint64_t                        reads = 0;
+      uint64_t                        writes = 0;
+      uint64_t                        secondary_reads = 0;
+      uint64_t                        secondary_writes = 0;
+      std::map<uint64_t, int64_t>     ram;                   // ram delta per payer
+      std::vector<std::vector<char>>  inline_actions;        // serialized eosio::action
+      std::vector<uint64_t>           notified;
+   };
+
+   // thrown by the assertion intrinsics and unwound through the contract up to `chain::guarded`
+   struct assertion_failure {
+      std::string message;
+   };
+
+   // in-memory state behind the db, auth, time and inline action intrinsics
+   class chain {
+      public:
+         chain();
+
+         // installs the intrinsics, only one chain can be active at a time
+         void activate();
+         static chain& active();
+
+         void set_time(uint64_t microseconds) { _now = microseconds; }
+         uint64_t time() const { return _now; }
+
+         void create_account(uint64_t account) { _accounts.insert(account); }
+         bool is_account(uint64_t account) const { return _accounts.count(account) > 0; }
+
+         // per action context: receiver, authorizations and the cost being recorded
+         void begin_action(uint64_t receiver, const std::set<uint64_t>& auths);
+         action_cost end_action();
+
+         // undo log covering all actions of a transaction
+         void begin_transaction();
+         void commit();
+         void rollback();
+
+         // runs `fn` and returns false with the assertion message if the contract fails a check
+         template <typename F>
+         bool guarded(F&& fn, std::string& error) {
+            _guards++;
+            try {
+               fn();
+            }
+            catch (const assertion_failure& failure) {
+               _guards--;
+               error = failure.message;
+               return false;
+            }
+            catch (...) {
+               _guards--;
+               throw;
+            }
+            _guards--;
+            return true;
+         }
+
+         [[noreturn]] void fail(const std::string& message);
+
+         uint64_t row_count(uint64_t code, uint64_t table) const;
+         int64_t ram_usage(uint64_t account) const;
+
+      private:
+         struct row {
+            uint64_t            payer;
+            std::vector<char>   data;
+         };
+
+         struct table {
+            table_key                   key;
+            uint64_t                    payer = 0;
+            int32_t                     end_iterator;
+            std::map<uint64_t, row>     rows;
+         };
+
+         template <typename K>
+         struct index {
+            table_key                                     key;
+            uint64_t                                      payer = 0;
+            int32_t                                       end_iterator;
+            std::set<std::pair<K, uint64_t>>              entries;      // secondary, primary
+            std::map<uint64_t, std::pair<K, uint64_t>>    by_primary;   // primary -> secondary, payer
+         };
+
+         template <typename K>
+         struct index_set {
+            int64_t                                       row_ram;
+            std::map<table_key, index<K>>                 indexes;
+            std::vector<index<K>*>                        by_end;
+            std::vector<std::pair<index<K>*, uint64_t>>   iterators;
+         };
+
+         struct undo_entry {
+            std::function<void()> restore;
+         };
+
+         table* find_table(uint64_t code, uint64_t scope, uint64_t tbl);
+         table& get_or_create_table(uint64_t scope, uint64_t tbl, uint64_t payer);
+         int32_t iterator_to(table& t, uint64_t primary);
+         table& table_of_end(int32_t end);
+         std::pair<table*, uint64_t> row_at(int32_t itr);
+         void bill(uint64_t payer, int64_t delta);
+
+         template <typename K> index<K>* find_index(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl);
+         template <typename K> index<K>& get_or_create_index(index_set<K>& set, uint64_t scope, uint64_t tbl, uint64_t payer);
+         template <typename K> int32_t index_iterator(index_set<K>& set, index<K>& idx, uint64_t primary);
+         template <typename K> std::pair<index<K>*, uint64_t> index_entry(index_set<K>& set, int32_t itr);
+
+         // intrinsic implementations
+         int32_t db_store(uint64_t scope, uint64_t tbl, uint64_t payer, uint64_t id, const void* data, uint32_t len);
+         void db_update(int32_t itr, uint64_t payer, const void* data, uint32_t len);
+         void db_remove(int32_t itr);
+         int32_t db_get(int32_t itr, void* data, uint32_t len);
+         int32_t db_next(int32_t itr, uint64_t* primary);
+         int32_t db_previous(int32_t itr, uint64_t* primary);
+         int32_t db_find(uint64_t code, uint64_t scope, uint64_t tbl, uint64_t id);
+         int32_t db_lowerbound(uint64_t code, uint64_t scope, uint64_t tbl, uint64_t id);
+         int32_t db_upperbound(uint64_t code, uint64_t scope, uint64_t tbl, uint64_t id);
+         int32_t db_end(uint64_t code, uint64_t scope, uint64_t tbl);
+
+         template <typename K> int32_t idx_store(index_set<K>& set, uint64_t scope, uint64_t tbl, uint64_t payer, uint64_t id, const K& secondary);
+         template <typename K> void idx_update(index_set<K>& set, int32_t itr, uint64_t payer, const K& secondary);
+         template <typename K> void idx_remove(index_set<K>& set, int32_t itr);
+         template <typename K> int32_t idx_next(index_set<K>& set, int32_t itr, uint64_t* primary);
+         template <typename K> int32_t idx_previous(index_set<K>& set, int32_t itr, uint64_t* primary);
+         template <typename K> int32_t idx_find_primary(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl, K& secondary, uint64_t primary);
+         template <typename K> int32_t idx_find_secondary(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl, const K& secondary, uint64_t* primary);
+         template <typename K> int32_t idx_lowerbound(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl, K& secondary, uint64_t* primary);
+         template <typename K> int32_t idx_upperbound(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl, K& secondary, uint64_t* primary);
+         template <typename K> int32_t idx_end(index_set<K>& set, uint64_t code, uint64_t scope, uint64_t tbl);
+
+         std::map<table_key, table>                    _tables;
+         std::vector<table*>                           _by_end;
+         std::vector<std::pair<table*, uint64_t>>      _iterators;
+         index_set<uint64_t>                           _idx64;
+         index_set<key256>                             _idx256;
+
+         std::set<uint64_t>                            _accounts;
+         std::map<uint64_t, int64_t>                   _ram;
+         uint64_t                                      _now = 0;
+
+         uint64_t                                      _receiver = 0;
+         std::set<uint64_t>                            _auths;
+         action_cost                                   _cost;
+
+         bool                                          _in_transaction = false;
+         std::vector<undo_entry>                       _undo;
+
+         uint32_t                                      _guards = 0;
+   };
+
+}
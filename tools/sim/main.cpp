@@ -0,0 +1,230 @@
+#include <simulator.hpp>
+#include <fixtures.hpp>
+#include <runtime.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace eosio;
+
+namespace {
+
+   const name SELF = "wraptoken"_n;
+   const name BRIDGE = "bridge"_n;
+   const name PROVER = "relayer"_n;
+   const name ALICE = "alice"_n;
+   const name BOB = "bob"_n;
+
+   const uint32_t FIRST_BLOCK = 200000000;
+
+   uint64_t block_time_us(uint32_t block_num) {
+      // matches the header timestamps produced by fixtures::make_header
+      return uint64_t(1700000000 + block_num / 2) * 1000000;
+   }
+
+   void print_header() {
+      printf("%-24s %-12s %6s %6s %6s %6s %6s %6s  %s\n", "transaction", "action", "reads", "writes", "2nd-r", "2nd-w", "inline", "notify", "ram delta");
+   }
+
+   void print(const char* label, const sim::transaction_result& result) {
+      for (const sim::action_record& a : result.actions) {
+         std::string ram;
+         for (const auto& [payer, delta] : a.cost.ram) ram += name(payer).to_string() + ":" + (delta >= 0 ? "+" : "") + std::to_string(delta) + " ";
+         std::string action = a.account == SELF ? a.action.to_string() : a.account.to_string() + "::" + a.action.to_string();
+         if (!a.executed) action += " (not run)";
+         printf("%-24s %-12s %6llu %6llu %6llu %6llu %6zu %6zu  %s\n", label, action.c_str(),
+                (unsigned long long)a.cost.reads, (unsigned long long)a.cost.writes,
+                (unsigned long long)a.cost.secondary_reads, (unsigned long long)a.cost.secondary_writes,
+                a.cost.inline_actions.size(), a.cost.notified.size(), ram.c_str());
+         label = "";
+      }
+      if (!result.success) printf("%-24s failed: %s\n", "", result.error.c_str());
+   }
+
+   void expect(const sim::transaction_result& result) {
+      if (!result.success) {
+         fprintf(stderr, "setup transaction failed: %s\n", result.error.c_str());
+         exit(1);
+      }
+   }
+
+   // scenario transactions whose outcome is not the expected one, the scenario exits non-zero if there are any
+   uint64_t unexpected = 0;
+
+   void expect(const char* label, const sim::transaction_result& result) {
+      print(label, result);
+      if (!result.success) {
+         printf("%-24s unexpected failure\n", "");
+         unexpected++;
+      }
+   }
+
+   void expect_failure(const char* label, const sim::transaction_result& result, const std::string& error) {
+      print(label, result);
+      if (result.success) {
+         printf("%-24s unexpected success, expected: %s\n", "", error.c_str());
+         unexpected++;
+      }
+      else if (result.error.find(error) == std::string::npos) {
+         printf("%-24s unexpected error, expected: %s\n", "", error.c_str());
+         unexpected++;
+      }
+   }
+
+   wraptoken::xfer lock(name owner, int64_t amount, name beneficiary) {
+      return wraptoken::xfer{ owner, extended_asset(asset(amount, symbol("EOS", 4)), fixtures::TOKEN), beneficiary };
+   }
+
+   void setup(sim::simulator& s, const checksum256& chain_id, const checksum256& paired_chain_id) {
+      for (name account : { PROVER, ALICE, BOB }) s.state().create_account(account.value);
+      s.state().set_time(block_time_us(FIRST_BLOCK));
+
+      expect(s.push("init"_n, { SELF }, [&](wraptoken& c) { c.init(chain_id, BRIDGE, paired_chain_id, fixtures::WRAPLOCK, fixtures::TOKEN); }));
+      expect(s.push("regsymbol"_n, { SELF }, [&](wraptoken& c) { c.regsymbol(asset((1LL<<62)-1, symbol("EOS", 4)), 0); }));
+      expect(s.push("enable"_n, { SELF }, [&](wraptoken& c) { c.enable(); }));
+   }
+
+   // one transaction of every user action against a freshly initialized contract
+   int scenario_actions() {
+      fixtures::rng r(7);
+      const checksum256 chain_id = r.digest();
+      const checksum256 paired_chain_id = r.digest();
+
+      sim::simulator s(SELF, BRIDGE);
+      setup(s, chain_id, paired_chain_id);
+
+      fixtures::proof_shape shape;
+      uint32_t block_num = FIRST_BLOCK;
+
+      auto b1 = fixtures::make_block(r, paired_chain_id, block_num++, { lock(ALICE, 100000, ALICE) }, shape);
+      auto b2 = fixtures::make_block(r, paired_chain_id, block_num++, { lock(BOB, 50000, BOB) }, shape);
+      auto b3 = fixtures::make_block(r, paired_chain_id, block_num++, { lock(ALICE, 10000, ALICE), lock(ALICE, 20000, BOB), lock(BOB, 30000, ALICE), lock(BOB, 40000, BOB) }, shape);
+      auto b4 = fixtures::make_block(r, paired_chain_id, block_num++, { lock(ALICE, 5000, ALICE) }, shape);
+      auto b5 = fixtures::make_block(r, paired_chain_id, block_num++, { lock(BOB, 5000, BOB) }, shape);
+      auto b6 = fixtures::make_block(r, paired_chain_id, block_num++, { lock(BOB, 5000, BOB) }, shape);
+      auto b7 = fixtures::make_block(r, paired_chain_id, block_num++, { lock(ALICE, 7000, ALICE), lock(BOB, 7000, BOB) }, shape);
+
+      s.state().set_time(block_time_us(block_num) + 1000000);
+
+      const symbol EOS("EOS", 4);
+
+      print_header();
+      expect("issuea", s.push("issuea"_n, { PROVER }, [&](wraptoken& c) { c.issuea(PROVER, b1.heavy, b1.actions[0]); }));
+      expect("issueb", s.push("issueb"_n, { PROVER }, [&](wraptoken& c) { c.issueb(PROVER, b2.light, b2.actions[0]); }));
+      expect_failure("issueb (replay)", s.push("issueb"_n, { PROVER }, [&](wraptoken& c) { c.issueb(PROVER, b2.light, b2.actions[0]); }),
+                     "action already proved");
+      expect("issuebatchb x4", s.push("issuebatchb"_n, { PROVER }, [&](wraptoken& c) { c.issuebatchb(PROVER, b3.light, b3.actions); }));
+      // close needs a zero balance, so the relayer opens and closes its row before the payout credits it
+      expect("open", s.push("open"_n, { PROVER }, [&](wraptoken& c) { c.open(PROVER, EOS, PROVER); }));
+      expect("close", s.push("close"_n, { PROVER }, [&](wraptoken& c) { c.close(PROVER, EOS); }));
+      expect("transfer", s.push("transfer"_n, { ALICE }, [&](wraptoken& c) { c.transfer(ALICE, BOB, asset(1000, EOS), "hi"); }));
+      expect("transfermany x2", s.push("transfermany"_n, { ALICE }, [&](wraptoken& c) {
+         c.transfermany(ALICE, { { BOB, asset(1000, EOS) }, { PROVER, asset(1000, EOS) } }, "payout");
+      }));
+      expect("retire", s.push("retire"_n, { BOB }, [&](wraptoken& c) { c.retire(BOB, asset(2000, EOS), BOB); }));
+      expect("retirebatch x3", s.push("retirebatch"_n, { BOB }, [&](wraptoken& c) {
+         c.retirebatch(BOB, { { asset(1000, EOS), ALICE }, { asset(1000, EOS), BOB }, { asset(500, EOS), PROVER } });
+      }));
+
+      // a second lock in an already proven block, checked against the cached root only
+      expect(s.push("setrootcache"_n, { SELF }, [&](wraptoken& c) { c.setrootcache(600); }));
+      expect("issueb (caching)", s.push("issueb"_n, { PROVER }, [&](wraptoken& c) { c.issueb(PROVER, b7.light, b7.actions[0]); }));
+      expect("issuec", s.push("issuec"_n, { PROVER }, [&](wraptoken& c) {
+         c.issuec(PROVER, paired_chain_id, b7.light.header.block_id(), b7.actions[1]);
+      }));
+
+      // the same retirements queued in the outbox and committed to by a single root
+      expect(s.push("setoutbox"_n, { SELF }, [&](wraptoken& c) { c.setoutbox(true, 0); }));
+      expect("retire (outbox)", s.push("retire"_n, { BOB }, [&](wraptoken& c) { c.retire(BOB, asset(2000, EOS), BOB); }));
+      expect("retirebatch x3 (outbox)", s.push("retirebatch"_n, { BOB }, [&](wraptoken& c) {
+         c.retirebatch(BOB, { { asset(1000, EOS), ALICE }, { asset(1000, EOS), BOB }, { asset(500, EOS), PROVER } });
+      }));
+      expect("commit x4", s.push("commit"_n, { PROVER }, [&](wraptoken& c) { c.commit(100); }));
+
+      // cancels need the lock to be older than the cancel delay
+      s.state().set_time(block_time_us(block_num) + 1000000000ULL);
+      expect("cancela", s.push("cancela"_n, { PROVER }, [&](wraptoken& c) { c.cancela(PROVER, b4.heavy, b4.actions[0]); }));
+      expect("cancelb", s.push("cancelb"_n, { PROVER }, [&](wraptoken& c) { c.cancelb(PROVER, b5.light, b5.actions[0]); }));
+
+      s.set_bridge_stub([](const action&) { return false; });
+      expect_failure("issueb (bad proof)", s.push("issueb"_n, { PROVER }, [&](wraptoken& c) { c.issueb(PROVER, b6.light, b6.actions[0]); }),
+                     "bridge rejected");
+
+      if (unexpected > 0) {
+         fprintf(stderr, "%llu transactions had an unexpected outcome\n", (unsigned long long)unexpected);
+         return 1;
+      }
+      return 0;
+   }
+
+   // issues one lock per block to a new beneficiary until `rows` receipts are stored, sampling the cost of an issue as state grows
+   int scenario_scale(uint64_t rows, uint32_t window) {
+      fixtures::rng r(11);
+      const checksum256 chain_id = r.digest();
+      const checksum256 paired_chain_id = r.digest();
+
+      sim::simulator s(SELF, BRIDGE);
+      setup(s, chain_id, paired_chain_id);
+      if (window > 0) expect(s.push("setreplay"_n, { SELF }, [&](wraptoken& c) { c.setreplay(window, 4); }));
+
+      fixtures::proof_shape shape;
+      shape.am_depth = 0;
+
+      printf("%12s %12s %12s  ", "receipts", "accounts", "ram(relayer)");
+      print_header();
+
+      uint64_t next_sample = 1;
+      for (uint64_t i = 0; i < rows; i++) {
+         uint32_t block_num = FIRST_BLOCK + uint32_t(i);
+         name beneficiary(0x1000000000000000ULL + (i << 4));
+         // the inline transfer of the default issue mode only credits existing accounts
+         s.state().create_account(beneficiary.value);
+         auto block = fixtures::make_block(r, paired_chain_id, block_num, { lock(ALICE, 10000, beneficiary) }, shape);
+         s.state().set_time(block_time_us(block_num) + 1000000);
+
+         auto result = s.push("issueb"_n, { PROVER }, [&](wraptoken& c) { c.issueb(PROVER, block.light, block.actions[0]); });
+         if (!result.success) {
+            fprintf(stderr, "issue %llu failed: %s\n", (unsigned long long)i, result.error.c_str());
+            return 1;
+         }
+
+         if (i + 1 == next_sample || i + 1 == rows) {
+            printf("%12llu %12llu %12lld  ", (unsigned long long)s.state().row_count(SELF.value, "receipts"_n.value),
+                   (unsigned long long)s.state().row_count(SELF.value, "accounts"_n.value), (long long)s.state().ram_usage(PROVER.value));
+            print("issueb", result);
+            next_sample *= 10;
+         }
+      }
+
+      return 0;
+   }
+
+   int usage(const char* program) {
+      printf("usage: %s actions\n", program);
+      printf("       %s scale [--rows <n>] [--window <seconds>]\n", program);
+      return 1;
+   }
+
+}
+
+int main(int argc, char** argv) {
+   runtime::install_crypto();
+
+   if (argc < 2) return usage(argv[0]);
+
+   if (!strcmp(argv[1], "actions")) return scenario_actions();
+
+   if (!strcmp(argv[1], "scale")) {
+      uint64_t rows = 1000000;
+      uint32_t window = 0;
+      for (int i = 2; i < argc; i++) {
+         if (!strcmp(argv[i], "--rows") && i + 1 < argc) rows = strtoull(argv[++i], nullptr, 10);
+         else if (!strcmp(argv[i], "--window") && i + 1 < argc) window = uint32_t(strtoul(argv[++i], nullptr, 10));
+         else return usage(argv[0]);
+      }
+      return scenario_scale(rows, window);
+   }
+
+   return usage(argv[0]);
+}
@@ -0,0 +1,96 @@
+#include <simulator.hpp>
+
+namespace sim {
+
+   std::set<uint64_t> to_raw(const std::set<name>& names) {
+      std::set<uint64_t> raw;
+      for (const name& n : names) raw.insert(n.value);
+      return raw;
+   }
+
+   simulator::simulator(name self, name bridge_contract) : _self(self), _bridge(bridge_contract) {
+      _bridge_stub = [](const eosio::action&) { return true; };
+      _chain.create_account(self.value);
+      _chain.create_account(bridge_contract.value);
+      _chain.activate();
+   }
+
+   bool simulator::run(name account, name action, const std::set<name>& auths, const action_body& body, transaction_result& result) {
+      _chain.begin_action(account.value, to_raw(auths));
+      bool ok = _chain.guarded([&]() {
+         eosio::wraptoken contract(_self, _self, eosio::datastream<const char*>(nullptr, 0));
+         body(contract);
+      }, result.error);
+      result.actions.push_back(action_record{ account, action, true, _chain.end_action() });
+      return ok;
+   }
+
+   bool simulator::dispatch_inline(const eosio::action& act, transaction_result& result) {
+      std::set<name> auths;
+      for (const eosio::permission_level& p : act.authorization) auths.insert(p.actor);
+
+      if (act.account == _bridge) {
+         _chain.begin_action(_bridge.value, to_raw(auths));
+         bool accepted = _bridge_stub(act);
+         result.actions.push_back(action_record{ act.account, act.name, true, _chain.end_action() });
+         if (!accepted) result.error = "bridge rejected " + act.name.to_string();
+         return accepted;
+      }
+
+      if (act.account != _self) {
+         result.actions.push_back(action_record{ act.account, act.name, false, action_cost{} });
+         return true;
+      }
+
+      if (act.name == "transfer"_n) {
+         auto args = eosio::unpack<std::tuple<name, name, eosio::asset, std::string>>(act.data);
+         return run(_self, act.name, auths, [&](eosio::wraptoken& c) {
+            c.transfer(std::get<0>(args), std::get<1>(args), std::get<2>(args), std::get<3>(args));
+         }, result);
+      }
+
+      if (act.name == "emitxfer"_n) {
+         auto xfer = eosio::unpack<eosio::wraptoken::xfer>(act.data);
+         return run(_self, act.name, auths, [&](eosio::wraptoken& c) { c.emitxfer(xfer); }, result);
+      }
+
+      if (act.name == "emitroot"_n) {
+         auto args = eosio::unpack<std::tuple<uint64_t, uint64_t, uint64_t, eosio::checksum256>>(act.data);
+         return run(_self, act.name, auths, [&](eosio::wraptoken& c) {
+            c.emitroot(std::get<0>(args), std::get<1>(args), std::get<2>(args), std::get<3>(args));
+         }, result);
+      }
+
+      result.error = "simulator cannot dispatch inline " + act.name.to_string();
+      return false;
+   }
+
+   bool simulator::run_inline(size_t sender, uint32_t depth, transaction_result& result) {
+      // copied, recording the actions below grows result.actions
+      const std::vector<std::vector<char>> sent = result.actions[sender].cost.inline_actions;
+      if (!sent.empty() && depth > MAX_INLINE_DEPTH) {
+         result.error = "max inline action depth per transaction reached";
+         return false;
+      }
+
+      for (const std::vector<char>& serialized : sent) {
+         const size_t index = result.actions.size();
+         if (!dispatch_inline(eosio::unpack<eosio::action>(serialized), result)) return false;
+         if (!run_inline(index, depth + 1, result)) return false;
+      }
+      return true;
+   }
+
+   transaction_result simulator::push(name action, const std::set<name>& auths, const action_body& body) {
+      transaction_result result;
+      _chain.begin_transaction();
+
+      const bool ok = run(_self, action, auths, body, result) && run_inline(0, 1, result);
+
+      result.success = ok;
+      if (ok) _chain.commit();
+      else _chain.rollback();
+      return result;
+   }
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chain.hpp>
+
+#include <wraptoken.hpp>
+
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+   using eosio::name;
+
+   // one executed (or, for other contracts, recorded) action of a transaction
+   struct action_record {
+      name          account;
+      name          action;
+      bool          executed;
+      action_cost   cost;
+   };
+
+   struct transaction_result {
+      bool                          success = true;
+      std::string                   error;
+      std::vector<action_record>    actions;
+   };
+
+   // runs wraptoken actions natively: inline actions to the contract itself are executed, inline actions to the bridge are
+   // answered by a stub that accepts or rejects the proof, and a failure anywhere rolls back the whole transaction
+   class simulator {
+      public:
+         // max_inline_action_depth of the nodeos genesis configuration
+         static constexpr uint32_t MAX_INLINE_DEPTH = 4;
+
+         using bridge_stub = std::function<bool(const eosio::action&)>;
+         using action_body = std::function<void(eosio::wraptoken&)>;
+
+         simulator(name self, name bridge_contract);
+
+         chain& state() { return _chain; }
+         name self() const { return _self; }
+
+         void set_bridge_stub(bridge_stub stub) { _bridge_stub = std::move(stub); }
+
+         transaction_result push(name action, const std::set<name>& auths, const action_body& body);
+
+      private:
+         bool run(name account, name action, const std::set<name>& auths, const action_body& body, transaction_result& result);
+         bool dispatch_inline(const eosio::action& act, transaction_result& result);
+
+         // runs the inline actions sent by the action recorded at `sender` in the order nodeos does: each one followed by its own
+         // inline actions, depth first, before the next one
+         bool run_inline(size_t sender, uint32_t depth, transaction_result& result);
+
+         chain         _chain;
+         name          _self;
+         name          _bridge;
+         bridge_stub   _bridge_stub;
+   };
+
+   std::set<uint64_t> to_raw(const std::set<name>& names);
+
+}